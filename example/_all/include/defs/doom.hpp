@@ -2,10 +2,17 @@
 
 #include "./base.hpp"
 #include <doom_view.hpp>
+#include <toon_boom/ext/view_registry.hpp>
 
 class DoomExample : public BaseExample {
 public:
   DoomExample() : BaseExample() {
+    m_doomView = util::layout::ViewRegistry::instance().add(
+        "DoomView", "Doom!?", []() -> TULayoutView * { return new DoomView(); },
+        {.docked = false,
+         .minSize = QSize(320, 200),
+         .position = QPoint(2020, 100),
+         .raiseName = "DoomView"});
   }
   ~DoomExample() {}
 
@@ -13,20 +20,18 @@ public:
   run() override {
     return
         [this](QScriptContext *context, QScriptEngine *engine) -> QScriptValue {
-          auto lm = PLUG_Services::getLayoutManager();
-          if(doomView == nullptr) {
-            doomView = new DoomView();
-            lm->addArea("DoomView", doomView->displayName(), doomView, true, true, false, QSize(320, 200), true, false, true, true);
+          auto &views = util::layout::ViewRegistry::instance();
+          if (!views.raise(m_doomView)) {
+            return engine->undefinedValue();
           }
-          lm->raiseArea("DoomView", nullptr, true, QPoint(2020, 100));
-          auto widget =
-                dynamic_cast<ToonDoomWidget *>(doomView->getWidget());
-                widget->start();
+          auto widget = dynamic_cast<ToonDoomWidget *>(
+              views.viewAs<DoomView>(m_doomView)->getWidget());
+          widget->start();
           return engine->undefinedValue();
         };
   }
   QString jsName() override { return "runDoom"; }
 
 private:
-  DoomView *doomView = nullptr;
+  util::layout::ViewHandle m_doomView;
 };
\ No newline at end of file
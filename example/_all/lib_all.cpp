@@ -4,11 +4,12 @@
 
 extern bool is_first_load;
 
-void AddExamples(QScriptEngine *engine) {
-  std::cout << "AddExamples" << std::endl;
+// Built the first time a script touches `extensionExamples`, not while
+// Harmony is constructing its script manager.
+QScriptValue CreateExamples(QScriptEngine *engine) {
+  std::cout << "CreateExamples" << std::endl;
   auto examples = new ToonBoomExamples();
-  engine->globalObject().setProperty("extensionExamples",
-                                     examples->getExamples(engine));
+  return examples->getExamples(engine);
 }
 
 extern "C" __declspec(dllexport) BOOL APIENTRY DllMain(HMODULE hModule,
@@ -20,7 +21,7 @@ extern "C" __declspec(dllexport) BOOL APIENTRY DllMain(HMODULE hModule,
     bool was_first_load = is_first_load;
     if (was_first_load) {
       // Sleep(20000);
-      Add_ScriptEngine_hook(&AddExamples);
+      Add_ScriptEngine_lazy_global("extensionExamples", &CreateExamples, 0);
     }
     if (hookInit() != TRUE) {
       std::cerr << "Failed to initialize hooks" << std::endl;
@@ -2,25 +2,26 @@
 #include "./include/examples_container.hpp"
 #include "./include/toolbar_view.hpp"
 #include "./include/basic_view.hpp"
-#include "toon_boom/ext/util.hpp"
-
-SimpleExamplesContainer::SimpleExamplesContainer() {}
+#include "toon_boom/ext/log.hpp"
+#include "toon_boom/ext/trace.hpp"
+
+// Registering is free until a view is first shown.
+SimpleExamplesContainer::SimpleExamplesContainer() {
+	auto &views = util::layout::ViewRegistry::instance();
+	m_greetingView = views.add(
+			"BasicGreetingView", "Basic Greeting View",
+			[]() -> TULayoutView* { return new BasicGreetingView(); },
+			{.docked = false, .minSize = QSize(400, 400), .position = QPoint(100, 100)});
+	m_counterView = views.add(
+			"Counter View", "Counter View",
+			[]() -> TULayoutView* { return new CounterView(); },
+			{.docked = false, .minSize = QSize(700, 400), .position = QPoint(200, 200)});
+}
 
 SimpleExamplesContainer::~SimpleExamplesContainer() {}
 
 void SimpleExamplesContainer::showBasicGreetingView() {
-	auto lm = PLUG_Services::getLayoutManager();
-	if (!lm) {
-		return;
-	}
-	const char* id = "BasicGreetingView";
-	const QString name = "Basic Greeting View";
-	auto viewFactory = []() -> TULayoutView* { return new BasicGreetingView(); };
-	if (!addViewIfNotExists(id, name, viewFactory, false, QSize(400, 400), true)) {
-		return;
-	}
-
-	lm->raiseArea(name, nullptr, true, QPoint(100, 100));
+	util::layout::ViewRegistry::instance().raise(m_greetingView);
 }
 
 void SimpleExamplesContainer::showCounterView() {
@@ -36,33 +37,11 @@ void SimpleExamplesContainer::showCounterView() {
 		return;
 	}
 
-	const QString name = "Counter View";
-
-	auto viewFactory = []() -> TULayoutView* { return new CounterView(); };
-	if (!addViewIfNotExists("Counter View", name, viewFactory, false, QSize(700, 400), true)) {
+	auto &views = util::layout::ViewRegistry::instance();
+	if (!views.raise(m_counterView)) {
 		return;
 	}
-	auto area = lm->raiseArea(name, nullptr, true, QPoint(200, 200));
-	debug::out << "Area: " << debug::addrToHex(area) << std::endl;
-	auto asCounterView = dynamic_cast<CounterView*>(m_views[name]);
+	auto asCounterView = views.viewAs<CounterView>(m_counterView);
 	asCounterView->getWidget()->setFocus(Qt::OtherFocusReason);
 	lm->showViewToolBars();
-}
-
-bool SimpleExamplesContainer::addViewIfNotExists(const char* id, const QString& displayName, std::function<TULayoutView*()> viewFactory, bool isDocked, QSize minSize, bool useMinSz) {
-	auto lm = PLUG_Services::getLayoutManager();
-	std::string asStr;
-	for (auto &c : displayName) {
-		asStr += c.toLatin1();
-	}
-	if (!m_views.contains(displayName)) {
-		m_views[displayName] = viewFactory();
-		bool res = lm->addArea(id, displayName, m_views[displayName], true, true, isDocked, minSize, useMinSz, false, true, true);
-		if (!res) {
-			debug::out << "Failed to add view " << asStr << " to layout!" << std::endl;
-			return false;
-		}
-		debug::out << "Successfully added view " << asStr << " to layout!" << std::endl;
-	}
-	return true;
 }
\ No newline at end of file
@@ -1,8 +1,7 @@
 #pragma once
-#include <functional>
-#include <map>
 #include <QtCore/QtCore>
 #include <toon_boom/toon_boom_layout.hpp>
+#include <toon_boom/ext/view_registry.hpp>
 
 class SimpleExamplesContainer {
 public:
@@ -11,6 +10,6 @@ public:
 	void showBasicGreetingView();
 	void showCounterView();
 	private:
-	bool addViewIfNotExists(const char* id, const QString& displayName, std::function<TULayoutView*()> viewFactory, bool isDocked = true, QSize minSize = QSize(500, 400), bool useMinSz = true);
-	std::map<QString, TULayoutView*> m_views;
+	util::layout::ViewHandle m_greetingView;
+	util::layout::ViewHandle m_counterView;
 };
\ No newline at end of file
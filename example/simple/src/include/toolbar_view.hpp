@@ -17,7 +17,7 @@ public:
 	void onParentDisconnect() override;
 	void afterWidgetCreated() override;
 private:
-	QDomDocument m_toolbarDoc;  // Must store document, not just element (QDomElement refs doc's data)
+	std::shared_ptr<const util::toolbar::Definition> m_toolbar;  // Owns the DOM toolbar() hands out
 	void initToolbar();
 	bool has_initialized_toolbar = false;
 };
\ No newline at end of file
@@ -1,14 +1,11 @@
 #include "./include/toolbar_view.hpp"
 #include "./include/widgets.hpp"
+#include "counter_toolbar.xml.hpp"
 #include <QtXml/QtXml>
 #include <iostream>
 #include <toon_boom/PLUG_Services.hpp>
-#include <toon_boom/ext/util.hpp>
+#include <toon_boom/ext/log.hpp>
 #include <toon_boom/toon_boom_layout.hpp>
-#include <toon_boom/ext/util.hpp>
-
-
-using namespace util;
 
 
 CounterView::CounterView()
@@ -22,9 +19,8 @@ CounterWidget *CounterView::createWidget() {
 void CounterView::afterWidgetCreated() { initToolbar(); }
 
 void CounterView::onParentDisconnect() {
-  debug::out << "Parent disconnected" << std::endl;
+  TB_LOG_DEBUG(Extension, "Parent disconnected");
   has_initialized_toolbar = false;
-  m_toolbarDoc = QDomDocument(); // Clear the document
 }
 CounterView::~CounterView() {}
 
@@ -36,58 +32,29 @@ void CounterView::initToolbar() {
   if (has_initialized_toolbar) {
     return;
   }
+  // src/toolbars/counter_toolbar.xml, validated and embedded at build time.
   QString errorMsg;
-  int errorLine = 0;
-  int errorCol = 0;
- 
-  std::string rawToolbarXml(R"XML(<?xml version="1.0" encoding="UTF-8"?>
-<toolbars>
-<toolbar id="TestToolbar" customizable="true" text="Test Toolbar" visible="true">
-<item icon="timeline/add.svg" id="INCREMENT_COUNTER" slot="onActionIncrementCounter()" responder="counter" text="Increment Counter" />
-<item icon="timeline/remove.svg" id="DECREMENT_COUNTER" slot="onActionDecrementCounter()" responder="counter" text="Decrement Counter" />
-<item icon="view/resetview.svg" id="RESET_COUNTER" slot="onActionResetCounter()" responder="counter" text="Reset Counter" />
-</toolbar>
-</toolbars>
-)XML");
-  QString rawToolbarXmlQStr(rawToolbarXml.c_str());
-  debug::out << "Toolbar xml: " << rawToolbarXml << std::endl;
-  bool success = m_toolbarDoc.setContent(rawToolbarXmlQStr,
-                                         &errorMsg, &errorLine, &errorCol);
-  if (errorLine != 0 || errorCol != 0 || !success) {
-    debug::out << "Error loading toolbar XML: "
-              << " at line " << errorLine << ", column " << errorCol
-              << std::endl;
-    std::string errStr;
-    for (auto &c : errorMsg) {
-      errStr += c.toLatin1();
-    }
-    debug::out << "Error message: " << errStr << std::endl;
+  m_toolbar = util::toolbar::load(embedded_xml::counter_toolbar, &errorMsg);
+  if (!m_toolbar) {
+    TB_LOG_ERROR(Extension, "Error loading toolbar XML: {}",
+                 errorMsg.toStdString());
     return;
   }
-  debug::out << "Toolbar document node count: "
-            << m_toolbarDoc.documentElement().childNodes().size() << std::endl;
+  TB_LOG_DEBUG(Extension, "Toolbar item count: {}", m_toolbar->items.size());
 
-  has_initialized_toolbar = registerToolbar(m_toolbarDoc.documentElement(), "TestToolbar");
+  has_initialized_toolbar = registerToolbar(*m_toolbar, "TestToolbar");
 }
 
 QDomElement CounterView::toolbar() {
   auto am = PLUG_Services::getActionManager();
   auto mgrEl = am->toolbarElement("TestToolbar");
-  debug::out << "mgr el" << std::endl;
-  /* if (mgrEl.isElement() && !mgrEl.isNull()) {
-    auto tagName = mgrEl.tagName();
-    debug::out << "\t<" << tagName.toStdString() << ">" << std::endl;
-  } */
-  debug::out << "\tis null: " << mgrEl.isNull() << std::endl
-            << "\tis element:" << mgrEl.isElement() << std::endl;
+  TB_LOG_DEBUG(Extension, "mgr el is null: {} is element: {}",
+               mgrEl.isNull(), mgrEl.isElement());
 
-  auto tbe = m_toolbarDoc.documentElement().firstChildElement();
-  {
-    auto id = tbe.attribute("id");
-    auto asStr = id.toStdString();
-    debug::out << "Getting toolbar: " << asStr
-    << std::endl;
+  if (!m_toolbar) {
+    return QDomElement();
   }
-  debug::out << "item count: " << tbe.childNodes().size() << std::endl;
-  return tbe;
+  TB_LOG_DEBUG(Extension, "Getting toolbar: {} item count: {}",
+               m_toolbar->id.toStdString(), m_toolbar->items.size());
+  return m_toolbar->toolbarElement();
 }
@@ -30,9 +30,7 @@ CounterWidget::CounterWidget(QWidget *parent)
     : WidgetWrapper(parent),
       AC_ResponderBase(IDENTITY, this,
                        PLUG_Services::getActionManager()) {
-  auto asResponderBase = dynamic_cast<AC_ResponderBase *>(this);
-  auto asResponder = dynamic_cast<AC_Responder *>(asResponderBase);
-  actionManager()->registerResponder(asResponder, this); 
+  util::responders::registerResponder(*this, this);
   m_mainLayout = new QVBoxLayout(m_wrapperFrame);
   QLabel *title = new QLabel("Test widget 2: Counter");
   title->setAlignment(Qt::AlignCenter);
@@ -71,6 +69,7 @@ void CounterWidget::onActionResetCounter() {
 }
 void CounterWidget::updateCounterLabel() {
   m_counterLabel->setText(QString::number(m_counter));
+  invalidateActions();
 }
 
 void CounterWidget::onActionIncrementCounterValidate(AC_ActionInfo *info) {
@@ -82,9 +81,11 @@ void CounterWidget::onActionDecrementCounterValidate(AC_ActionInfo *info) {
 }
 
 void CounterWidget::onActionResetCounterValidate(AC_ActionInfo *info) {
-  info->setEnabled(m_counter != 0);
+  validateCached(info, "reset", [this](util::actions::ActionState &state) {
+    state.enabled = m_counter != 0;
+  });
 }
 
 int CounterWidget::counter() const { return m_counter; }
 
-CounterWidget::~CounterWidget() { actionManager()->unregisterResponder(this); }
\ No newline at end of file
+CounterWidget::~CounterWidget() { util::responders::unregisterResponder(*this); }
\ No newline at end of file
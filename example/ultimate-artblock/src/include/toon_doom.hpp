@@ -8,6 +8,7 @@
 #include <QtWidgets/QtWidgets>
 #include <set>
 #include <toon_boom/ext/layout.hpp>
+#include <toon_boom/ext/log.hpp>
 #include <toon_boom/ext/util.hpp>
 
 #include "./common.h"
@@ -90,8 +91,7 @@ public:
                         &ToonDoomWidget::focusChanged);
     auto inp =
         AttachThreadInput(GetCurrentThreadId(), doomThread->getId(), false);
-    util::debug::out << "~ToonDoomWidget AttachThreadInput: " << inp
-                     << std::endl;
+    TB_LOG_DEBUG(Extension, "~ToonDoomWidget AttachThreadInput: {}", inp);
     delete doomThread;
   }
   void setApp(app_t *app) {
@@ -132,7 +132,8 @@ protected:
     updateGeometry();
   }
   void focusInEvent(QFocusEvent *event) override {
-    util::debug::out << "focusInEvent: " << event->type() << std::endl;
+    TB_LOG_TRACE(Extension, "focusInEvent: {}",
+                 static_cast<int>(event->type()));
     if (app) {
       app->has_focus = true;
       SetFocus(app->hwnd);
@@ -141,9 +142,8 @@ protected:
   }
 
   bool eventFilter(QObject *obj, QEvent *event) override {
-    QMetaEnum metaEnum = QMetaEnum::fromType<QEvent::Type>();
-    util::debug::out << "eventFilter: " << metaEnum.valueToKey(event->type())
-                     << " obj: " << obj->metaObject()->className() << std::endl;
+    TB_LOG_TRACE(Extension, "eventFilter: {} obj: {}", eventTypeName(event),
+                 obj->metaObject()->className());
     if (event->type() == QEvent::WindowActivate ||
         (event->type() == QEvent::FocusIn && obj != this)) {
       this->setFocus(Qt::OtherFocusReason);
@@ -159,12 +159,12 @@ protected:
   bool event(QEvent *event) override {
     if (event->type() == QEvent::FocusOut ||
         event->type() == QEvent::FocusAboutToChange) {
-      util::debug::out << "focus out" << std::endl;
+      TB_LOG_TRACE(Extension, "focus out");
       setEnabled(true);
       if (event->type() == QEvent::FocusOut) {
         auto asFocusEvent = static_cast<QFocusEvent *>(event);
-        util::debug::out << "focus out reason: " << asFocusEvent->reason()
-                         << std::endl;
+        TB_LOG_TRACE(Extension, "focus out reason: {}",
+                     static_cast<int>(asFocusEvent->reason()));
         if (asFocusEvent->reason() == Qt::OtherFocusReason) {
           event->ignore();
           setFocus();
@@ -185,6 +185,12 @@ private:
         new QKeyEvent(QEvent::KeyRelease, Qt::Key_Escape, Qt::NoModifier));
   }
 
+  static const char *eventTypeName(QEvent *event) {
+    const char *name =
+        QMetaEnum::fromType<QEvent::Type>().valueToKey(event->type());
+    return name ? name : "?";
+  }
+
   bool isMouseMoveEvent(QEvent *event) {
     return event->type() == QEvent::MouseMove ||
            event->type() == QEvent::Enter || event->type() == QEvent::Leave ||
@@ -209,7 +215,7 @@ private slots:
     }
   }
   void windowClosed() {
-    util::debug::out << "window closed" << std::endl;
+    TB_LOG_DEBUG(Extension, "window closed");
     delete doomThread;
     doomThread = nullptr;
   }
@@ -226,16 +232,16 @@ private slots:
         QWidget::createWindowContainer(m_window, this, Qt::WindowType::Widget);
     doomWidget->setSizePolicy(QSizePolicy::MinimumExpanding,
                               QSizePolicy::MinimumExpanding);
-    util::debug::out << "doomwidget == window: "
-                     << (doomWidget->windowHandle() == m_window) << std::endl;
+    TB_LOG_DEBUG(Extension, "doomwidget == window: {}",
+                 doomWidget->windowHandle() == m_window);
     auto flags = doomWidget->windowFlags();
 
     doomWidget->hide();
     m_layout->addWidget(doomWidget, 1);
-    util::debug::out << "doom thread id: " << doomThread->getId() << std::endl;
+    TB_LOG_DEBUG(Extension, "doom thread id: {}", doomThread->getId());
     auto inp =
         AttachThreadInput(GetCurrentThreadId(), doomThread->getId(), true);
-    util::debug::out << "AttachThreadInput: " << inp << std::endl;
+    TB_LOG_DEBUG(Extension, "AttachThreadInput: {}", inp);
     doomWidget->show();
     auto parentWindow = window();
     updateGeometry();
@@ -244,10 +250,8 @@ private slots:
       // add widget hierarchy to a set for focus tracking
       QWidget *p = doomWidget;
       while (p != nullptr) {
-        util::debug::out << "widget @ " << util::debug::addrToHex(p) << ": "
-                         << p->metaObject()->className() << " parent: "
-                         << util::debug::addrToHex(p->parentWidget())
-                         << std::endl;
+        TB_LOG_DEBUG(Extension, "widget @ {}: {} parent: {}", p,
+                     p->metaObject()->className(), p->parentWidget());
         m_ancestors.insert(p);
 
         p = p->parentWidget();
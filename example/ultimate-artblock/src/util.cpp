@@ -1,6 +1,5 @@
 #include "./include/util.hpp"
-#include <toon_boom/ext/util.hpp>
-using namespace util;
+#include <toon_boom/ext/log.hpp>
 void sendEscapeKeyToWindow(HWND hwnd) {
   {
     SetForegroundWindow(hwnd);
@@ -16,7 +15,7 @@ void sendEscapeKeyToWindow(HWND hwnd) {
 
     UINT uSent = SendInput(ARRAYSIZE(inputs), inputs, sizeof(INPUT));
     
-		debug::out << "SendInput: " << uSent << std::endl;
+		TB_LOG_DEBUG(Extension, "SendInput: {}", uSent);
     
   }
 }
\ No newline at end of file
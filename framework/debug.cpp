@@ -1,7 +1,40 @@
 #include "include/public/toon_boom/ext/util.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+
+#include <string>
 
 namespace util::debug {
+namespace {
+
+// Collects one line per thread and hands it to the async logger on '\n', so
+// `debug::out << ... << std::endl` never blocks on console or file I/O.
+struct LogLineBuffer : std::streambuf {
+  int overflow(int c) override {
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    put(static_cast<char>(c));
+    return c;
+  }
+
+  std::streamsize xsputn(const char *s, std::streamsize n) override {
+    for (std::streamsize i = 0; i < n; ++i) put(s[i]);
+    return n;
+  }
+
+  static void put(char c) {
+    thread_local std::string line;
+    if (c == '\n') {
+      log::write(log::Level::Debug, line);
+      line.clear();
+    } else {
+      line.push_back(c);
+    }
+  }
+};
+
+} // namespace
+
 	std::ostream devnull(new NullBuffer());
+	std::ostream logstream(new LogLineBuffer());
 	
-	std::ostream& out = TB_EXT_FRAMEWORK_DEBUG ? std::cout : devnull;	
+	std::ostream& out = TB_EXT_FRAMEWORK_DEBUG ? logstream : devnull;	
 }
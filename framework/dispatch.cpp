@@ -0,0 +1,110 @@
+#include "include/public/toon_boom/ext/dispatch.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+#include "include/public/toon_boom/ext/metrics.hpp"
+#include "include/public/toon_boom/ext/util.hpp"
+
+#include <QtCore/QMetaMethod>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+namespace util::actions {
+
+DispatchTable &DispatchTable::forMetaObject(const QMetaObject *metaObject) {
+  // Leaked; metaobjects are static and outlive every lookup.
+  static auto *tables =
+      new std::unordered_map<const QMetaObject *, std::unique_ptr<DispatchTable>>();
+  auto &table = (*tables)[metaObject];
+  if (!table) {
+    static auto &built = metrics::counter("actions.dispatch_tables");
+    built.add();
+    table.reset(new DispatchTable(metaObject));
+  }
+  return *table;
+}
+
+DispatchTable::DispatchTable(const QMetaObject *metaObject)
+    : m_metaObject(metaObject) {
+  for (int i = 0; i < metaObject->methodCount(); i++) {
+    auto method = metaObject->method(i);
+    if (method.methodType() != QMetaMethod::Slot &&
+        method.methodType() != QMetaMethod::Method) {
+      continue;
+    }
+    // invoke() passes an AC_ActionInfo* as the one argument; a slot taking
+    // anything else would get it reinterpreted.
+    if (method.parameterCount() > 1) continue;
+    if (method.parameterCount() == 1 &&
+        method.parameterTypes().front() != "AC_ActionInfo*") {
+      continue;
+    }
+    auto signature = method.methodSignature().toStdString();
+    m_entries.push_back({fnv1a(signature), std::move(signature), i,
+                         method.parameterCount(), nullptr});
+  }
+  std::sort(m_entries.begin(), m_entries.end(),
+            [](const Entry &a, const Entry &b) { return a.hash < b.hash; });
+  TB_LOG_DEBUG(Actions, "Dispatch table for {}: {} slots",
+               metaObject->className(), m_entries.size());
+}
+
+const DispatchTable::Entry *
+DispatchTable::find(std::string_view signature) const {
+  const auto hash = fnv1a(signature);
+  auto it = std::lower_bound(
+      m_entries.begin(), m_entries.end(), hash,
+      [](const Entry &entry, std::uint64_t key) { return entry.hash < key; });
+  for (; it != m_entries.end() && it->hash == hash; ++it) {
+    if (it->signature == signature) return &*it;
+  }
+  return nullptr;
+}
+
+bool DispatchTable::contains(std::string_view signature) const {
+  return find(signature) != nullptr;
+}
+
+bool DispatchTable::invoke(QObject *object, std::string_view signature,
+                           AC_ActionInfo *info) const {
+  static auto &thunked = metrics::counter("actions.dispatch_thunk");
+  static auto &indexed = metrics::counter("actions.dispatch_indexed");
+  const Entry *entry = find(signature);
+  if (!entry) {
+    // Hand-written names may not be normalized ("foo( )"); only pay for
+    // normalizing on a miss.
+    auto normalized = QMetaObject::normalizedSignature(
+        std::string(signature).c_str());
+    entry = find(std::string_view(normalized.constData(),
+                                  static_cast<std::size_t>(normalized.size())));
+    if (!entry) return false;
+  }
+  if (entry->thunk) {
+    thunked.add();
+    entry->thunk(object, info);
+    return true;
+  }
+  indexed.add();
+  if (entry->parameterCount == 1) {
+    void *args[] = {nullptr, &info};
+    QMetaObject::metacall(object, QMetaObject::InvokeMetaMethod,
+                          entry->methodIndex, args);
+  } else {
+    void *args[] = {nullptr};
+    QMetaObject::metacall(object, QMetaObject::InvokeMetaMethod,
+                          entry->methodIndex, args);
+  }
+  return true;
+}
+
+void DispatchTable::setThunk(std::string_view signature, Thunk thunk) {
+  for (auto &entry : m_entries) {
+    if (entry.signature == signature) {
+      entry.thunk = thunk;
+      return;
+    }
+  }
+  TB_LOG_WARN(Actions, "{} has no slot {} to bind", m_metaObject->className(),
+              std::string(signature));
+}
+
+} // namespace util::actions
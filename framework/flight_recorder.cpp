@@ -0,0 +1,141 @@
+#include "include/public/toon_boom/ext/flight_recorder.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include <windows.h>
+
+namespace util::recorder {
+namespace {
+
+constexpr std::size_t kWords = sizeof(Event) / sizeof(std::uint64_t);
+
+// Seqlock slot. seq is 2 * ticket + 1 while the event for ticket is being
+// written and 2 * ticket + 2 once it is complete. The payload is stored as
+// relaxed atomic words so a reader racing a writer is merely discarded, not
+// undefined behaviour.
+struct alignas(64) Slot {
+  std::atomic<std::uint64_t> seq{0};
+  std::array<std::atomic<std::uint64_t>, kWords> words{};
+};
+static_assert(sizeof(Slot) == 64);
+
+Slot g_slots[kCapacity];
+std::atomic<std::uint64_t> g_next{0};
+
+void store(Slot &slot, std::uint64_t ticket, const Event &event) {
+  std::array<std::uint64_t, kWords> raw;
+  std::memcpy(raw.data(), &event, sizeof(Event));
+  slot.seq.store(2 * ticket + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (std::size_t i = 0; i < kWords; ++i) {
+    slot.words[i].store(raw[i], std::memory_order_relaxed);
+  }
+  slot.seq.store(2 * ticket + 2, std::memory_order_release);
+}
+
+bool load(const Slot &slot, std::uint64_t ticket, Event &event) {
+  const auto expected = 2 * ticket + 2;
+  if (slot.seq.load(std::memory_order_acquire) != expected) return false;
+  std::array<std::uint64_t, kWords> raw;
+  for (std::size_t i = 0; i < kWords; ++i) {
+    raw[i] = slot.words[i].load(std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.seq.load(std::memory_order_relaxed) != expected) return false;
+  std::memcpy(&event, raw.data(), sizeof(Event));
+  return true;
+}
+
+const char *kindName(Kind kind) {
+  switch (kind) {
+  case Kind::Note:
+    return "note";
+  case Kind::Resolve:
+    return "resolve";
+  case Kind::HookStatus:
+    return "hook";
+  case Kind::Engine:
+    return "engine";
+  case Kind::Timing:
+    return "timing";
+  case Kind::Failure:
+    return "FAILURE";
+  }
+  return "?";
+}
+
+// Serializes dumps so two failing threads do not interleave one file.
+std::mutex g_dumpMutex;
+
+} // namespace
+
+void record(Kind kind, std::string_view label, std::uint64_t a,
+            std::uint64_t b) {
+  Event event;
+  event.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+  event.a = a;
+  event.b = b;
+  event.threadId = static_cast<std::uint32_t>(GetCurrentThreadId());
+  event.kind = kind;
+  event.length = static_cast<std::uint8_t>(
+      label.copy(event.label, Event::kLabelCapacity));
+  const auto ticket = g_next.fetch_add(1, std::memory_order_relaxed);
+  store(g_slots[ticket & (kCapacity - 1)], ticket, event);
+}
+
+std::vector<Event> events() {
+  const auto end = g_next.load(std::memory_order_acquire);
+  const auto begin = end > kCapacity ? end - kCapacity : 0;
+  std::vector<Event> result;
+  result.reserve(static_cast<std::size_t>(end - begin));
+  for (auto ticket = begin; ticket < end; ++ticket) {
+    Event event;
+    if (load(g_slots[ticket & (kCapacity - 1)], ticket, event)) {
+      result.push_back(event);
+    }
+  }
+  return result;
+}
+
+bool dump(const std::filesystem::path &path, std::string_view reason) {
+  const auto snapshot = events();
+  std::string out = std::format("flight recorder dump: {}\npid {}, {} events\n",
+                                reason, GetCurrentProcessId(), snapshot.size());
+  for (const auto &event : snapshot) {
+    const std::chrono::system_clock::time_point tp{
+        std::chrono::system_clock::duration{event.timestamp}};
+    std::format_to(std::back_inserter(out),
+                   "{:%Y-%m-%d %H:%M:%S}Z {:>5} {:<8} {:<26} 0x{:X} {}\n",
+                   std::chrono::floor<std::chrono::microseconds>(tp),
+                   event.threadId, kindName(event.kind),
+                   std::string_view(event.label, event.length), event.a,
+                   event.b);
+  }
+
+  std::lock_guard lock(g_dumpMutex);
+  std::error_code ec;
+  std::filesystem::create_directories(path.parent_path(), ec);
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) return false;
+  file.write(out.data(), static_cast<std::streamsize>(out.size()));
+  return file.good();
+}
+
+std::filesystem::path dumpToDefault(std::string_view reason) {
+  std::error_code ec;
+  auto dir = std::filesystem::temp_directory_path(ec);
+  if (ec) return {};
+  auto path = dir / "toon-boom-extension-framework" /
+              std::format("flight-{}.log", GetCurrentProcessId());
+  if (!dump(path, reason)) return {};
+  return path;
+}
+
+} // namespace util::recorder
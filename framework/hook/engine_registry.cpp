@@ -0,0 +1,215 @@
+#include "../include/internal/engine_registry.hpp"
+#include "../include/internal/hook_registry.hpp"
+#include "../include/public/toon_boom/ext/flight_recorder.hpp"
+#include "../include/public/toon_boom/ext/log.hpp"
+#include "../include/public/toon_boom/ext/metrics.hpp"
+#include "../include/public/toon_boom/ext/trace.hpp"
+#include "../include/public/toon_boom/ext/util.hpp"
+
+#include <QtCore/QMetaObject>
+#include <QtScript/QScriptContext>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <string>
+#include <string_view>
+
+extern QScriptEngine *global_engine_ptr;
+
+namespace toon_boom_module::hooks {
+namespace {
+
+// Anything slower than this is logged as a warning even with debug output off.
+constexpr auto kSlowHookThreshold = std::chrono::milliseconds(50);
+
+struct AddressLabel {
+  char text[96];
+  std::size_t size;
+
+  operator std::string_view() const { return {text, size}; }
+};
+
+// "some_extension.dll+0x1A2B" for an address inside a loaded module, so a slow
+// hook can be traced back to the extension that registered it. Built on the
+// stack; nothing here allocates.
+AddressLabel describe_address(const void *addr) {
+  AddressLabel label;
+  HMODULE module = NULL;
+  if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                             GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                         reinterpret_cast<LPCSTR>(addr), &module)) {
+    char path[MAX_PATH] = {};
+    const DWORD length = GetModuleFileNameA(module, path, MAX_PATH);
+    if (length != 0) {
+      const std::string_view full(path, length);
+      const auto name = full.substr(full.find_last_of("\\/") + 1);
+      const auto offset = reinterpret_cast<std::uintptr_t>(addr) -
+                          reinterpret_cast<std::uintptr_t>(module);
+      const auto result = std::format_to_n(label.text, sizeof(label.text),
+                                           "{}+0x{:X}", name, offset);
+      label.size = std::min(static_cast<std::size_t>(result.size),
+                            sizeof(label.text));
+      return label;
+    }
+  }
+  const auto hex = util::debug::toHex(addr);
+  label.size = hex.view().copy(label.text, sizeof(label.text));
+  return label;
+}
+
+template <typename Fn>
+void run_timed(const char *phase, const void *fn_addr, std::string_view label,
+               QScriptEngine *engine, Fn &&fn) {
+  util::trace::Scope span("hooks", phase);
+  if (span.active()) span.setDetail(describe_address(fn_addr));
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  static auto &runs = util::metrics::counter("hooks.runs");
+  static auto &slow = util::metrics::counter("hooks.slow");
+  static auto &latency = util::metrics::histogram("hooks.run_ns");
+  runs.add();
+  latency.record(static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+  const auto us =
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  util::recorder::record(util::recorder::Kind::Timing, phase,
+                         reinterpret_cast<std::uintptr_t>(fn_addr),
+                         static_cast<std::uint64_t>(us));
+  if (elapsed >= kSlowHookThreshold) {
+    slow.add();
+    TB_LOG_WARN(Hooks, "slow extension hook {}{} ({}) took {} ms",
+                describe_address(fn_addr), label, phase, us / 1000);
+  } else {
+    TB_LOG_DEBUG(Hooks, "{} {}{} on engine {} took {} us", phase,
+                 describe_address(fn_addr), label, engine, us);
+  }
+}
+
+// Shared getter/setter for lazy globals. The callee's data object holds the
+// factory and, once materialized, the cached value.
+QScriptValue lazy_global_accessor(QScriptContext *context,
+                                  QScriptEngine *engine) {
+  QScriptValue state = context->callee().data();
+  if (context->argumentCount() == 1) {
+    state.setProperty("value", context->argument(0));
+    return context->argument(0);
+  }
+  QScriptValue value = state.property("value");
+  if (value.isValid()) return value;
+
+  auto factory = reinterpret_cast<ScriptEngine_property_factory_t>(
+      state.property("factory").toVariant().value<void *>());
+  const auto name = state.property("name").toString().toStdString();
+  run_timed("lazy global", reinterpret_cast<const void *>(factory),
+            std::format(" ({})", name), engine,
+            [&]() { value = factory(engine); });
+  state.setProperty("value", value);
+  return value;
+}
+
+void install_lazy_global(QScriptEngine *engine, const HookEntry &entry) {
+  const auto name = QString::fromStdString(entry.global_name);
+  QScriptValue state = engine->newObject();
+  state.setProperty("name", name);
+  state.setProperty("factory",
+                    engine->newVariant(QVariant::fromValue<void *>(
+                        reinterpret_cast<void *>(entry.factory))));
+  QScriptValue accessor = engine->newFunction(lazy_global_accessor);
+  accessor.setData(state);
+  engine->globalObject().setProperty(
+      name, accessor,
+      QScriptValue::PropertyGetter | QScriptValue::PropertySetter);
+}
+
+} // namespace
+
+bool EngineRegistry::track(QScriptEngine *engine) {
+  if (!engine) return false;
+  {
+    std::lock_guard lock(m_mutex);
+    auto [it, inserted] = m_engines.try_emplace(engine);
+    if (!inserted) return false;
+    it->second.engine = engine;
+  }
+  util::metrics::counter("script_engine.tracked").add();
+  util::metrics::gauge("script_engine.live").add(1);
+  // Captures the raw pointer only as a map key; it is never dereferenced
+  // after destruction.
+  QObject::connect(engine, &QObject::destroyed,
+                   [this, engine]() { forget(engine); });
+  return true;
+}
+
+void EngineRegistry::apply_pending(QScriptEngine *engine) {
+  TB_TRACE_SCOPE("hooks", "apply_pending");
+  for (const auto &entry : script_engine_hooks().read()) {
+    {
+      std::lock_guard lock(m_mutex);
+      auto it = m_engines.find(engine);
+      if (it == m_engines.end() || !it->second.engine) return;
+      if (!it->second.applied.insert(entry.token).second) continue;
+    }
+    if (entry.flags & kHookLazyGlobal) {
+      install_lazy_global(engine, entry);
+    } else if (entry.flags & kHookDeferred) {
+      auto hook = entry.hook;
+      QMetaObject::invokeMethod(
+          engine,
+          [hook, engine]() {
+            run_timed("deferred hook", reinterpret_cast<const void *>(hook),
+                      "", engine, [&]() { hook(engine); });
+          },
+          Qt::QueuedConnection);
+    } else {
+      run_timed("hook", reinterpret_cast<const void *>(entry.hook), "",
+                engine, [&]() { entry.hook(engine); });
+    }
+  }
+}
+
+void EngineRegistry::replay_to_live_engines() {
+  for (auto *engine : live_engines()) {
+    // engine doubles as the context object, so the call is dropped if the
+    // engine dies before the event is delivered.
+    QMetaObject::invokeMethod(
+        engine, [this, engine]() { apply_pending(engine); },
+        Qt::QueuedConnection);
+  }
+}
+
+std::vector<QScriptEngine *> EngineRegistry::live_engines() const {
+  std::lock_guard lock(m_mutex);
+  std::vector<QScriptEngine *> engines;
+  engines.reserve(m_engines.size());
+  for (const auto &[key, state] : m_engines) {
+    if (state.engine) engines.push_back(state.engine.data());
+  }
+  return engines;
+}
+
+void EngineRegistry::forget(QScriptEngine *engine) {
+  std::lock_guard lock(m_mutex);
+  if (m_engines.erase(engine) != 0) {
+    util::metrics::gauge("script_engine.live").add(-1);
+    util::recorder::record(util::recorder::Kind::Engine, "engine destroyed",
+                           reinterpret_cast<std::uintptr_t>(engine));
+  }
+  if (global_engine_ptr == engine) {
+    global_engine_ptr = NULL;
+    for (const auto &[key, state] : m_engines) {
+      if (state.engine) {
+        global_engine_ptr = state.engine.data();
+        break;
+      }
+    }
+  }
+}
+
+EngineRegistry &script_engines() {
+  static EngineRegistry registry;
+  return registry;
+}
+
+} // namespace toon_boom_module::hooks
@@ -0,0 +1,85 @@
+#include "../include/internal/framework_globals.hpp"
+#include "../include/public/hooks/toon_boom_hooks.hpp"
+#include "../include/public/toon_boom/ext/flight_recorder.hpp"
+#include "../include/public/toon_boom/ext/metrics.hpp"
+
+#include <QtScript/QScriptContext>
+#include <QtScript/QScriptEngine>
+
+#include <string>
+
+namespace toon_boom_module::hooks {
+namespace {
+
+// frameworkMetrics.snapshot() ->
+//   { counters: {name: n}, gauges: {name: n},
+//     histograms: {name: {count, sum, max, p50, p90, p99}} }
+// Values are JS numbers, so counts above 2^53 lose precision.
+QScriptValue metrics_snapshot(QScriptContext *, QScriptEngine *engine) {
+  const auto snapshot = util::metrics::snapshot();
+  QScriptValue counters = engine->newObject();
+  for (const auto &[name, value] : snapshot.counters) {
+    counters.setProperty(QString::fromStdString(name),
+                         QScriptValue(static_cast<double>(value)));
+  }
+  QScriptValue gauges = engine->newObject();
+  for (const auto &[name, value] : snapshot.gauges) {
+    gauges.setProperty(QString::fromStdString(name),
+                       QScriptValue(static_cast<double>(value)));
+  }
+  QScriptValue histograms = engine->newObject();
+  for (const auto &[name, h] : snapshot.histograms) {
+    QScriptValue entry = engine->newObject();
+    entry.setProperty("count", QScriptValue(static_cast<double>(h.count)));
+    entry.setProperty("sum", QScriptValue(static_cast<double>(h.sum)));
+    entry.setProperty("max", QScriptValue(static_cast<double>(h.max)));
+    entry.setProperty("p50", QScriptValue(static_cast<double>(h.p50)));
+    entry.setProperty("p90", QScriptValue(static_cast<double>(h.p90)));
+    entry.setProperty("p99", QScriptValue(static_cast<double>(h.p99)));
+    histograms.setProperty(QString::fromStdString(name), entry);
+  }
+  QScriptValue result = engine->newObject();
+  result.setProperty("counters", counters);
+  result.setProperty("gauges", gauges);
+  result.setProperty("histograms", histograms);
+  return result;
+}
+
+// frameworkMetrics.toJson() -> the same document the periodic dump writes.
+QScriptValue metrics_to_json(QScriptContext *, QScriptEngine *) {
+  return QScriptValue(
+      QString::fromStdString(util::metrics::toJson(util::metrics::snapshot())));
+}
+
+QScriptValue create_metrics_global(QScriptEngine *engine) {
+  QScriptValue metrics = engine->newObject();
+  metrics.setProperty("snapshot", engine->newFunction(metrics_snapshot));
+  metrics.setProperty("toJson", engine->newFunction(metrics_to_json));
+  return metrics;
+}
+
+// frameworkFlightRecorder.dump([reason]) -> path of the dump, or "" if it
+// could not be written.
+QScriptValue flight_recorder_dump(QScriptContext *context, QScriptEngine *) {
+  const auto reason = context->argumentCount() > 0
+                          ? context->argument(0).toString().toStdString()
+                          : std::string("requested from script");
+  const auto path = util::recorder::dumpToDefault(reason);
+  return QScriptValue(QString::fromStdWString(path.wstring()));
+}
+
+QScriptValue create_flight_recorder_global(QScriptEngine *engine) {
+  QScriptValue recorder = engine->newObject();
+  recorder.setProperty("dump", engine->newFunction(flight_recorder_dump));
+  return recorder;
+}
+
+} // namespace
+
+void install_framework_globals() {
+  Add_ScriptEngine_lazy_global("frameworkMetrics", &create_metrics_global, 0);
+  Add_ScriptEngine_lazy_global("frameworkFlightRecorder",
+                               &create_flight_recorder_global, 0);
+}
+
+} // namespace toon_boom_module::hooks
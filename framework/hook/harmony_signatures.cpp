@@ -1,6 +1,7 @@
 #include "harmony_signatures.hpp"
 
 #include "sigscan.hpp"
+#include "../include/public/toon_boom/ext/trace.hpp"
 
 #include <algorithm>
 #include <array>
@@ -80,6 +81,7 @@ std::optional<FunctionRange> function_range_from_unwind(HMODULE target_module, s
 }  // namespace
 
 std::optional<std::uintptr_t> find_SCR_ScriptRuntime_getEngine(HMODULE target_module) {
+  TB_TRACE_SCOPE("sigscan", "find_SCR_ScriptRuntime_getEngine");
   // Exact bytes from IDA at HarmonyPremium.exe:0x14082BCD0:
   //   48 8B 01 48 8B 40 28 C3
   constexpr std::string_view kPattern = "48 8B 01 48 8B 40 28 C3";
@@ -106,6 +108,7 @@ std::optional<std::uintptr_t> find_SCR_ScriptRuntime_getEngine(HMODULE target_mo
 }
 
 std::optional<std::uintptr_t> find_SCR_ScriptManager_ctor(HMODULE target_module) {
+  TB_TRACE_SCOPE("sigscan", "find_SCR_ScriptManager_ctor");
   // This is a mid-function signature extracted from HarmonyPremium.exe around:
   //   QString("___scriptManager___"); defineGlobalQObject(...)
   //   QString("include");           defineGlobalFunction(QS_include)
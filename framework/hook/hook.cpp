@@ -1,82 +1,170 @@
 #include "../include/public/hooks/toon_boom_hooks.hpp"
 #include "../include/internal/harmony_signatures.hpp"
-#include <iostream>
-#include <vector>
+#include "../include/internal/engine_registry.hpp"
+#include "../include/internal/framework_globals.hpp"
+#include "../include/internal/hook_registry.hpp"
+#include "../include/public/toon_boom/ext/flight_recorder.hpp"
+#include "../include/public/toon_boom/ext/log.hpp"
+#include "../include/public/toon_boom/ext/metrics.hpp"
+#include "../include/public/toon_boom/ext/trace.hpp"
 
 QScriptEngine *global_engine_ptr = NULL;
 bool is_first_load = true;
 SCR_ScriptManager_ctor_t SCR_ScriptManager_ctor_original_ptr = NULL;
-std::vector<ScriptEngine_hook_t> script_engine_hooks;
+
+// Logs the failure and dumps the flight recorder, so a failed start on an
+// artist's machine leaves a file behind with what led up to it.
+static void report_failure(const char *what, std::uint64_t detail = 0) {
+  TB_LOG_ERROR(Hooks, "{}", what);
+  util::recorder::record(util::recorder::Kind::Failure, what, detail);
+  const auto path = util::recorder::dumpToDefault(what);
+  if (!path.empty()) {
+    TB_LOG_ERROR(Hooks, "flight recorder written to {}", path.string());
+  }
+}
 
 void *SCR_ScriptManager_ctor_hook(void *_this, void *_engine, void *_parent) {
-  std::cout << "SCR_ScriptManager_ctor_hook" << std::endl;
-	void *result = SCR_ScriptManager_ctor_original_ptr(_this, _engine, _parent);
+  TB_TRACE_SCOPE("hooks", "SCR_ScriptManager_ctor_hook");
+  TB_LOG_INFO(Hooks, "SCR_ScriptManager_ctor_hook");
+  util::metrics::counter("script_engine.managers_constructed").add();
+	void *result = NULL;
+  {
+    TB_TRACE_SCOPE("harmony", "SCR_ScriptManager_ctor");
+    result = SCR_ScriptManager_ctor_original_ptr(_this, _engine, _parent);
+  }
 	HMODULE target_module = GetModuleHandle(NULL);
-	std::optional<std::uintptr_t> SCR_ScripRuntime_getEngine_original =
-      toon_boom_module::harmony::find_SCR_ScriptRuntime_getEngine(
-          target_module);
+	// Resolved once; rescanning .text on every manager construction was most of
+	// this hook's own cost.
+	static const std::optional<std::uintptr_t> SCR_ScripRuntime_getEngine_original =
+      [target_module]() {
+        auto resolved =
+            toon_boom_module::harmony::find_SCR_ScriptRuntime_getEngine(
+                target_module);
+        util::recorder::record(util::recorder::Kind::Resolve,
+                               "SCR_ScriptRuntime_getEngine",
+                               resolved.value_or(0));
+        return resolved;
+      }();
   if (SCR_ScripRuntime_getEngine_original == std::nullopt) {
-    std::cerr << "Failed to find SCR_ScriptRuntime_getEngine" << std::endl;
+    report_failure("Failed to find SCR_ScriptRuntime_getEngine");
     return result;
   }
   auto SCR_ScripRuntime_getEngine_original_ptr = reinterpret_cast<SCR_ScriptRuntime_getEngine_t>(SCR_ScripRuntime_getEngine_original.value());
 
 	void* mgr_data = *reinterpret_cast<void**>(reinterpret_cast<std::byte*>(_this) + 0x20);
 	if (!mgr_data) {
-    std::cerr << "SCR_ScriptManager data pointer was null" << std::endl;
+    report_failure("SCR_ScriptManager data pointer was null",
+                   reinterpret_cast<std::uintptr_t>(_this));
     return result;
   }
   void* runtime_handle = *reinterpret_cast<void**>(mgr_data);
   if (!runtime_handle) {
-    std::cerr << "SCR_ScriptManager runtime handle was null" << std::endl;
+    report_failure("SCR_ScriptManager runtime handle was null",
+                   reinterpret_cast<std::uintptr_t>(mgr_data));
     return result;
   }
   QScriptEngine* engine = SCR_ScripRuntime_getEngine_original_ptr(runtime_handle);
   if (!engine) {
-    std::cerr << "SCR_ScriptRuntime_getEngine returned null" << std::endl;
+    report_failure("SCR_ScriptRuntime_getEngine returned null",
+                   reinterpret_cast<std::uintptr_t>(runtime_handle));
     return result;
   }
   global_engine_ptr = engine;
-  for(auto hook : script_engine_hooks) {
-    hook(engine);
+  auto &engines = toon_boom_module::hooks::script_engines();
+  const bool is_new_engine = engines.track(engine);
+  util::recorder::record(util::recorder::Kind::Engine,
+                         is_new_engine ? "engine created" : "engine reused",
+                         reinterpret_cast<std::uintptr_t>(engine),
+                         reinterpret_cast<std::uintptr_t>(_this));
+  if (!is_new_engine) {
+    TB_LOG_INFO(Hooks, "ScriptEngine already initialized, running new hooks only");
   }
+  engines.apply_pending(engine);
   return result;
 }
 
 void Add_ScriptEngine_hook(ScriptEngine_hook_t hook) {
-  script_engine_hooks.push_back(hook);
+  Add_ScriptEngine_hook_ex(hook, 0);
+}
+
+static ScriptEngine_hook_token_t add_hook_entry(toon_boom_module::hooks::HookEntry entry) {
+  auto token = toon_boom_module::hooks::script_engine_hooks().add(std::move(entry));
+  if (token != 0) {
+    toon_boom_module::hooks::script_engines().replay_to_live_engines();
+  }
+  return token;
+}
+
+ScriptEngine_hook_token_t Add_ScriptEngine_hook_ex(ScriptEngine_hook_t hook, int priority) {
+  toon_boom_module::hooks::HookEntry entry;
+  entry.hook = hook;
+  entry.priority = priority;
+  return add_hook_entry(std::move(entry));
+}
+
+ScriptEngine_hook_token_t Add_ScriptEngine_hook_deferred(ScriptEngine_hook_t hook, int priority) {
+  toon_boom_module::hooks::HookEntry entry;
+  entry.hook = hook;
+  entry.priority = priority;
+  entry.flags = toon_boom_module::hooks::kHookDeferred;
+  return add_hook_entry(std::move(entry));
+}
+
+ScriptEngine_hook_token_t Add_ScriptEngine_lazy_global(const char* name, ScriptEngine_property_factory_t factory, int priority) {
+  if (!name || !factory) {
+    return 0;
+  }
+  toon_boom_module::hooks::HookEntry entry;
+  entry.factory = factory;
+  entry.global_name = name;
+  entry.priority = priority;
+  entry.flags = toon_boom_module::hooks::kHookLazyGlobal;
+  return add_hook_entry(std::move(entry));
+}
+
+bool Remove_ScriptEngine_hook(ScriptEngine_hook_token_t token) {
+  return toon_boom_module::hooks::script_engine_hooks().remove(token);
 }
 
 BOOL hookInit() {
 	if(!is_first_load) {
 		return TRUE;
 	}
-	if(MH_Initialize() != MH_OK) {
-		std::cerr << "Failed to initialize MinHook" << std::endl;
+	TB_TRACE_SCOPE("startup", "hookInit");
+	MH_STATUS status = MH_Initialize();
+	util::recorder::record(util::recorder::Kind::HookStatus, "MH_Initialize", 0, status);
+	if(status != MH_OK) {
+		report_failure("Failed to initialize MinHook", status);
 		return FALSE;
 	}
 	auto scr_ScriptManager_ctor_ptr = toon_boom_module::harmony::find_SCR_ScriptManager_ctor(GetModuleHandle(NULL));
+	util::recorder::record(util::recorder::Kind::Resolve, "SCR_ScriptManager_ctor",
+	                       scr_ScriptManager_ctor_ptr.value_or(0));
 	if(scr_ScriptManager_ctor_ptr == std::nullopt) {
-		std::cerr << "Failed to find SCR_ScriptManager_ctor" << std::endl;
+		report_failure("Failed to find SCR_ScriptManager_ctor");
 		return FALSE;
 	}
 	auto SCR_ScriptManager_ctor_original_ptr_val = reinterpret_cast<SCR_ScriptManager_ctor_t>(scr_ScriptManager_ctor_ptr.value());
-	MH_STATUS status = MH_CreateHook(
+	status = MH_CreateHook(
 		reinterpret_cast<LPVOID>(SCR_ScriptManager_ctor_original_ptr_val),
 		reinterpret_cast<LPVOID>(&SCR_ScriptManager_ctor_hook),
 		reinterpret_cast<LPVOID *>(&SCR_ScriptManager_ctor_original_ptr));
+	util::recorder::record(util::recorder::Kind::HookStatus, "MH_CreateHook",
+	                       scr_ScriptManager_ctor_ptr.value(), status);
 	if(status != MH_OK) {
-		std::cerr << "Failed to create hook for SCR_ScriptManager_ctor" << std::endl;
+		report_failure("Failed to create hook for SCR_ScriptManager_ctor", status);
 		return FALSE;
 	}
 	status = MH_EnableHook(MH_ALL_HOOKS);
+	util::recorder::record(util::recorder::Kind::HookStatus, "MH_EnableHook", 0, status);
 	if(status != MH_OK) {
-		std::cerr << "Failed to enable hooks" << std::endl;
+		report_failure("Failed to enable hooks", status);
 		MH_RemoveHook(reinterpret_cast<LPVOID>(SCR_ScriptManager_ctor_original_ptr_val));
 		MH_Uninitialize();
 		return FALSE;
 	}
-	std::cout << "Hooks initialized and enabled" << std::endl;
+	toon_boom_module::hooks::install_framework_globals();
+	TB_LOG_INFO(Hooks, "Hooks initialized and enabled");
 	is_first_load = false;
 	return TRUE;
 }
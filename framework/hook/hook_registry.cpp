@@ -0,0 +1,129 @@
+#include "../include/internal/hook_registry.hpp"
+
+#include <algorithm>
+
+namespace toon_boom_module::hooks {
+
+HookRegistry::ReadGuard::ReadGuard(const HookRegistry &registry)
+    : m_registry(registry) {
+  // Must be seq_cst on both sides: a writer that swaps m_current and then
+  // reads m_active_readers == 0 is guaranteed that we either haven't loaded
+  // yet (and will see the new snapshot) or have already finished.
+  m_registry.m_active_readers.fetch_add(1, std::memory_order_seq_cst);
+  m_snapshot = m_registry.m_current.load(std::memory_order_seq_cst);
+}
+
+HookRegistry::ReadGuard::~ReadGuard() {
+  m_registry.m_active_readers.fetch_sub(1, std::memory_order_release);
+}
+
+HookRegistry::HookRegistry() : m_current(new HookSnapshot()) {}
+
+HookRegistry::~HookRegistry() {
+  delete m_current.load(std::memory_order_relaxed);
+  auto *retired = m_retired.load(std::memory_order_relaxed);
+  while (retired) {
+    auto *next = retired->next_retired;
+    delete retired;
+    retired = next;
+  }
+}
+
+ScriptEngine_hook_token_t HookRegistry::add(HookEntry entry) {
+  if (!entry.hook && !entry.factory) return 0;
+
+  const auto token = m_next_token.fetch_add(1, std::memory_order_relaxed);
+  const auto priority = entry.priority;
+  entry.token = token;
+  auto *next = new HookSnapshot();
+  HookSnapshot *prev = nullptr;
+  {
+    // Copying out of prev makes us a reader of it until the CAS lands.
+    ReadGuard guard(*this);
+    prev = m_current.load(std::memory_order_seq_cst);
+    do {
+      next->entries = prev->entries;
+      auto pos = std::find_if(
+          next->entries.begin(), next->entries.end(),
+          [priority](const HookEntry &e) { return e.priority < priority; });
+      next->entries.insert(pos, entry);
+    } while (!m_current.compare_exchange_weak(prev, next,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_seq_cst));
+    retire(prev);
+  }
+  reclaim();
+  return token;
+}
+
+bool HookRegistry::remove(ScriptEngine_hook_token_t token) {
+  if (token == 0) return false;
+
+  auto *next = new HookSnapshot();
+  bool found = false;
+  {
+    ReadGuard guard(*this);
+    HookSnapshot *prev = m_current.load(std::memory_order_seq_cst);
+    do {
+      next->entries.clear();
+      next->entries.reserve(prev->entries.size());
+      found = false;
+      for (const auto &e : prev->entries) {
+        if (e.token == token) {
+          found = true;
+          continue;
+        }
+        next->entries.push_back(e);
+      }
+      if (!found) break;
+    } while (!m_current.compare_exchange_weak(prev, next,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_seq_cst));
+    if (found) retire(prev);
+  }
+  if (!found) {
+    delete next;
+    return false;
+  }
+  reclaim();
+  return true;
+}
+
+void HookRegistry::retire(HookSnapshot *snapshot) {
+  push_retired(snapshot, snapshot);
+}
+
+void HookRegistry::push_retired(HookSnapshot *first, HookSnapshot *last) {
+  auto *head = m_retired.load(std::memory_order_relaxed);
+  do {
+    last->next_retired = head;
+  } while (!m_retired.compare_exchange_weak(head, first,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
+
+void HookRegistry::reclaim() {
+  // Everything on the list was unlinked from m_current before this exchange,
+  // so only readers that are in flight right now can still hold it.
+  auto *list = m_retired.exchange(nullptr, std::memory_order_seq_cst);
+  if (!list) return;
+
+  if (m_active_readers.load(std::memory_order_seq_cst) != 0) {
+    auto *last = list;
+    while (last->next_retired) last = last->next_retired;
+    push_retired(list, last);
+    return;
+  }
+  while (list) {
+    auto *next = list->next_retired;
+    delete list;
+    list = next;
+  }
+}
+
+HookRegistry &script_engine_hooks() {
+  static HookRegistry registry;
+  return registry;
+}
+
+} // namespace toon_boom_module::hooks
@@ -1,4 +1,6 @@
 #include "../include/internal/sigscan.hpp"
+#include "../include/public/toon_boom/ext/metrics.hpp"
+#include "../include/public/toon_boom/ext/tasks.hpp"
 
 #include <algorithm>
 #include <cctype>
@@ -93,19 +95,19 @@ std::optional<SectionView> get_pe_section(HMODULE module, std::string_view secti
   return std::nullopt;
 }
 
-std::vector<const std::byte*> find_all(SectionView region, const Pattern& pat) {
-  std::vector<const std::byte*> matches;
+namespace {
 
-  if (!region.begin || region.size == 0) return matches;
-  if (pat.bytes.size() != pat.mask.size()) return matches;
-  if (pat.bytes.empty()) return matches;
-  if (region.size < pat.bytes.size()) return matches;
+// Regions with fewer candidate offsets than this are scanned inline.
+constexpr std::size_t kParallelScanThreshold = 4u << 20;
+constexpr std::size_t kScanChunk = 1u << 20;
 
+// Appends matches that start in [first, last) to out.
+void scan_range(SectionView region, const Pattern& pat, std::size_t first,
+                std::size_t last, std::vector<const std::byte*>& out) {
   const auto* hay = reinterpret_cast<const std::uint8_t*>(region.begin);
-  const auto hay_size = region.size;
   const auto n = pat.bytes.size();
-
-  for (std::size_t i = 0; i + n <= hay_size; ++i) {
+  last = std::min(last, region.size - n + 1);
+  for (std::size_t i = first; i < last; ++i) {
     bool ok = true;
     for (std::size_t j = 0; j < n; ++j) {
       if (pat.mask[j] && hay[i + j] != pat.bytes[j]) {
@@ -113,9 +115,42 @@ std::vector<const std::byte*> find_all(SectionView region, const Pattern& pat) {
         break;
       }
     }
-    if (ok) matches.push_back(region.begin + i);
+    if (ok) out.push_back(region.begin + i);
+  }
+}
+
+}  // namespace
+
+std::vector<const std::byte*> find_all(SectionView region, const Pattern& pat) {
+  static auto& scans = util::metrics::counter("sigscan.scans");
+  static auto& latency = util::metrics::histogram("sigscan.find_all_ns");
+  scans.add();
+  util::metrics::ScopedTimer timer(latency);
+  std::vector<const std::byte*> matches;
+
+  if (!region.begin || region.size == 0) return matches;
+  if (pat.bytes.size() != pat.mask.size()) return matches;
+  if (pat.bytes.empty()) return matches;
+  if (region.size < pat.bytes.size()) return matches;
+
+  const auto starts = region.size - pat.bytes.size() + 1;
+  if (starts < kParallelScanThreshold) {
+    scan_range(region, pat, 0, starts, matches);
+    return matches;
   }
 
+  // Harmony's .text is tens of MB; split it across the task pool. Each chunk
+  // keeps its own matches so the result stays in address order.
+  const auto chunks = (starts + kScanChunk - 1) / kScanChunk;
+  std::vector<std::vector<const std::byte*>> per_chunk(chunks);
+  util::tasks::parallelFor(0, starts, kScanChunk,
+                           [&](std::size_t first, std::size_t last) {
+                             scan_range(region, pat, first, last,
+                                        per_chunk[first / kScanChunk]);
+                           });
+  for (const auto& chunk : per_chunk) {
+    matches.insert(matches.end(), chunk.begin(), chunk.end());
+  }
   return matches;
 }
 
@@ -0,0 +1,686 @@
+#include "include/public/toon_boom/ext/icons.hpp"
+#include "include/internal/vtable_hook.hpp"
+#include "include/public/toon_boom/ac_manager.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+#include "include/public/toon_boom/ext/metrics.hpp"
+#include "include/public/toon_boom/ext/tasks.hpp"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtGui/QIconEngine>
+#include <QtGui/QPainter>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QStyle>
+#include <QtWidgets/QStyleOption>
+
+#include <algorithm>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <windows.h>
+
+namespace util::icons {
+namespace {
+
+constexpr int kPageSize = 1024;
+constexpr const char *kIndexHeader = "toon-boom-icons 2";
+constexpr int kLoadImageSlot = 60;
+// Variants not looked up in this many sessions are dropped from the index.
+constexpr int kIdleSessions = 30;
+// Pages are repacked once dead area (replaced or idle variants) reaches a
+// quarter page and a third of everything allocated.
+constexpr qint64 kCompactMinimum = qint64{kPageSize} * kPageSize / 4;
+
+bool g_hookDisabled = false;
+
+struct IconCacheFromEnvironment {
+  IconCacheFromEnvironment() {
+    char value[8] = {};
+    if (GetEnvironmentVariableA("TB_EXT_ICON_CACHE", value, sizeof(value)) == 0) {
+      return;
+    }
+    g_hookDisabled = value[0] == '0';
+  }
+} icon_cache_from_environment;
+
+std::filesystem::path defaultDirectory() {
+  char base[MAX_PATH] = {};
+  DWORD n = GetEnvironmentVariableA("LOCALAPPDATA", base, MAX_PATH);
+  if (n == 0 || n >= MAX_PATH) return {};
+  return std::filesystem::path(base) / "toon-boom-extension-framework" / "icons";
+}
+
+std::filesystem::path pagePath(const std::filesystem::path &directory, int file) {
+  return directory / std::format("atlas-{}.png", file);
+}
+
+struct Slot {
+  int page;
+  QRect rect;
+  qint64 mtime;
+  int lastUsed; // session number
+};
+
+struct Shelf {
+  int y;
+  int height;
+  int x;
+};
+
+struct Page {
+  int file;   // atlas-<file>.png; a repacked page gets a new one
+  QSize size;
+  QImage image; // null until a slot on the page is read or written
+  bool onDisk = false;
+  std::vector<Shelf> shelves;
+  int nextY = 0;
+  qint64 usedArea = 0;
+  qint64 liveArea = 0;
+  bool dirty = false;
+};
+
+qint64 areaOf(const QRect &rect) {
+  return qint64{rect.width()} * rect.height();
+}
+
+// Only the index is read when the cache is first used; a page's image is
+// decoded when a variant on it is first needed or a new one is packed onto
+// it. Pages stay open for packing across sessions. Replaced and idle
+// variants leave dead area behind, which compact() reclaims.
+class Atlas {
+public:
+  static Atlas &instance() {
+    // Leaked: QPixmaps must not be destroyed after QGuiApplication.
+    static auto *atlas = new Atlas();
+    return *atlas;
+  }
+
+  QPixmap pixmap(const QString &source, int size, qreal dpr, const QColor &blend,
+                 QIcon::Mode mode) {
+    static auto &memoryHits = metrics::counter("icons.memory_hits");
+    static auto &diskHits = metrics::counter("icons.disk_hits");
+    static auto &rendered = metrics::counter("icons.rendered");
+    static auto &latency = metrics::histogram("icons.render_ns");
+    if (source.isEmpty() || size <= 0) return QPixmap();
+    ensureLoaded();
+
+    const auto key = keyOf(source, size, dpr, blend, mode);
+    if (auto it = m_pixmaps.find(key); it != m_pixmaps.end()) {
+      memoryHits.add();
+      return it->second;
+    }
+
+    const auto mtime = sourceMtime(source);
+    QImage image;
+    auto it = m_slots.find(key);
+    if (it != m_slots.end() && it->second.mtime == mtime) {
+      // A copy: pageImage() drops the slots of a page it cannot read,
+      // this one included.
+      const Slot slot = it->second;
+      image = pageImage(slot.page).copy(slot.rect);
+    }
+    if (!image.isNull() && m_slots.contains(key)) {
+      diskHits.add();
+      auto &slot = m_slots[key];
+      if (slot.lastUsed != m_session) {
+        slot.lastUsed = m_session;
+        scheduleSave();
+      }
+    } else {
+      rendered.add();
+      metrics::ScopedTimer timer(latency);
+      image = render(source, qRound(size * dpr), blend, mode);
+      store(key, image, mtime);
+    }
+    auto result = QPixmap::fromImage(image);
+    result.setDevicePixelRatio(dpr);
+    m_pixmaps.emplace(key, result);
+    return result;
+  }
+
+  void setDirectory(const std::filesystem::path &directory) {
+    if (m_loaded) {
+      TB_LOG_WARN(General, "Icon cache directory set after first use; ignored");
+      return;
+    }
+    m_directory = directory;
+  }
+
+  void clear() {
+    ensureLoaded();
+    m_pixmaps.clear();
+    m_slots.clear();
+    m_pages.clear();
+    m_mtimes.clear();
+    {
+      // A queued write must not bring back what is being removed.
+      std::lock_guard lock(m_pending.mutex);
+      m_pending.pages.clear();
+      m_pending.liveFiles.clear();
+      m_pending.index.clear();
+      m_pending.generation++;
+    }
+    std::lock_guard writing(m_writeMutex);
+    std::error_code ec;
+    if (!m_directory.empty()) std::filesystem::remove_all(m_directory, ec);
+  }
+
+private:
+  Atlas() : m_directory(defaultDirectory()) {}
+
+  static std::string keyOf(const QString &source, int size, qreal dpr,
+                           const QColor &blend, QIcon::Mode mode) {
+    const bool tinted = blend.isValid() && blend.alpha() != 0;
+    return std::format("{}|{}|{}|{:08x}|{}", source.toStdString(), size,
+                       qRound(dpr * 100), tinted ? blend.rgba() : 0u,
+                       static_cast<int>(mode));
+  }
+
+  qint64 sourceMtime(const QString &source) {
+    // Stat each source once per session; the cache only has to notice
+    // files changed between runs.
+    auto [it, inserted] = m_mtimes.try_emplace(source.toStdString(), 0);
+    if (inserted) {
+      it->second = QFileInfo(source).lastModified().toMSecsSinceEpoch();
+    }
+    return it->second;
+  }
+
+  static QImage render(const QString &source, int pixels, const QColor &blend,
+                       QIcon::Mode mode) {
+    QImage image(pixels, pixels, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+      QPainter painter(&image);
+      QIcon(source).paint(&painter, QRect(0, 0, pixels, pixels));
+      if (blend.isValid() && blend.alpha() != 0) {
+        painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        painter.fillRect(image.rect(), blend);
+      }
+    }
+    if (mode != QIcon::Normal && qobject_cast<QApplication *>(QCoreApplication::instance())) {
+      QStyleOption option;
+      option.palette = QApplication::palette();
+      image = QApplication::style()
+                  ->generatedIconPixmap(mode, QPixmap::fromImage(image), &option)
+                  .toImage()
+                  .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+    return image;
+  }
+
+  Page newPage(QSize size) {
+    Page page;
+    page.file = m_nextFile++;
+    page.size = size;
+    page.image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    page.image.fill(Qt::transparent);
+    return page;
+  }
+
+  // The page's pixels, decoding them on first use. A page that cannot be
+  // read starts over blank and its variants are rendered again.
+  QImage &pageImage(int number) {
+    auto &page = m_pages[number];
+    if (!page.image.isNull()) return page.image;
+    static auto &loads = metrics::counter("icons.pages_loaded");
+    if (page.onDisk) {
+      QImage image(QString::fromStdWString(pagePath(m_directory, page.file).wstring()));
+      if (image.size() == page.size) {
+        loads.add();
+        page.image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        return page.image;
+      }
+      TB_LOG_WARN(General, "Icon atlas page {} is missing or damaged", page.file);
+    }
+    std::erase_if(m_slots, [number](const auto &entry) {
+      return entry.second.page == number;
+    });
+    page.liveArea = 0;
+    page.image = QImage(page.size, QImage::Format_ARGB32_Premultiplied);
+    page.image.fill(Qt::transparent);
+    page.dirty = true;
+    return page.image;
+  }
+
+  // Shelf packing: an icon goes on the first shelf tall enough with room
+  // left, else on a new shelf, else on a new page.
+  Slot allocate(std::vector<Page> &pages, QSize size) {
+    const qint64 area = qint64{size.width()} * size.height();
+    if (size.width() > kPageSize || size.height() > kPageSize) {
+      auto page = newPage(size);
+      page.nextY = size.height();
+      page.usedArea = area;
+      pages.push_back(std::move(page));
+      return {static_cast<int>(pages.size() - 1), QRect(QPoint(0, 0), size), 0, 0};
+    }
+    for (int i = 0; i < static_cast<int>(pages.size()); i++) {
+      auto &page = pages[i];
+      if (page.size.width() < kPageSize) continue; // an oversized icon's own
+      for (auto &shelf : page.shelves) {
+        if (shelf.height >= size.height() && shelf.x + size.width() <= kPageSize) {
+          QRect rect(shelf.x, shelf.y, size.width(), size.height());
+          shelf.x += size.width();
+          page.usedArea += area;
+          return {i, rect, 0, 0};
+        }
+      }
+      if (page.nextY + size.height() <= page.size.height()) {
+        page.shelves.push_back({page.nextY, size.height(), size.width()});
+        QRect rect(0, page.nextY, size.width(), size.height());
+        page.nextY += size.height();
+        page.usedArea += area;
+        return {i, rect, 0, 0};
+      }
+    }
+    auto page = newPage(QSize(kPageSize, kPageSize));
+    page.shelves.push_back({0, size.height(), size.width()});
+    page.nextY = size.height();
+    page.usedArea = area;
+    pages.push_back(std::move(page));
+    return {static_cast<int>(pages.size() - 1), QRect(QPoint(0, 0), size), 0, 0};
+  }
+
+  void store(const std::string &key, const QImage &image, qint64 mtime) {
+    if (auto old = m_slots.find(key); old != m_slots.end()) {
+      m_pages[old->second.page].liveArea -= areaOf(old->second.rect);
+    }
+    auto slot = allocate(m_pages, image.size());
+    slot.mtime = mtime;
+    slot.lastUsed = m_session;
+    auto &target = pageImage(slot.page);
+    {
+      QPainter painter(&target);
+      painter.setCompositionMode(QPainter::CompositionMode_Source);
+      painter.drawImage(slot.rect.topLeft(), image);
+    }
+    auto &page = m_pages[slot.page];
+    page.liveArea += areaOf(slot.rect);
+    page.dirty = true;
+    m_slots[key] = slot;
+    scheduleSave();
+  }
+
+  bool shouldCompact() const {
+    qint64 used = 0;
+    qint64 live = 0;
+    for (const auto &page : m_pages) {
+      used += page.usedArea;
+      live += page.liveArea;
+    }
+    const qint64 dead = used - live;
+    return dead >= kCompactMinimum && dead * 3 >= used;
+  }
+
+  // Repacks the live variants, tallest first, onto fresh pages. Decodes
+  // every page still holding one, so it only runs once enough is dead.
+  void compact() {
+    static auto &compactions = metrics::counter("icons.compactions");
+    compactions.add();
+    std::unordered_set<int> used;
+    for (const auto &[key, slot] : m_slots) used.insert(slot.page);
+    // May drop the slots of pages that cannot be read.
+    for (int page : used) pageImage(page);
+    std::vector<std::pair<const std::string, Slot> *> live;
+    live.reserve(m_slots.size());
+    for (auto &entry : m_slots) live.push_back(&entry);
+    std::sort(live.begin(), live.end(), [](const auto *a, const auto *b) {
+      return a->second.rect.height() != b->second.rect.height()
+                 ? a->second.rect.height() > b->second.rect.height()
+                 : a->second.rect.width() > b->second.rect.width();
+    });
+
+    const auto before = m_pages.size();
+    std::vector<Page> pages;
+    for (auto *entry : live) {
+      auto &slot = entry->second;
+      auto moved = allocate(pages, slot.rect.size());
+      {
+        QPainter painter(&pages[moved.page].image);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(moved.rect.topLeft(), m_pages[slot.page].image, slot.rect);
+      }
+      pages[moved.page].liveArea += areaOf(moved.rect);
+      pages[moved.page].dirty = true;
+      slot.page = moved.page;
+      slot.rect = moved.rect;
+    }
+    m_pages = std::move(pages);
+    TB_LOG_DEBUG(General, "Icon cache: repacked {} variants from {} pages onto {}",
+                 m_slots.size(), before, m_pages.size());
+  }
+
+  void ensureLoaded() {
+    if (m_loaded) return;
+    m_loaded = true;
+    if (m_directory.empty()) return;
+    std::ifstream in(m_directory / "index.txt");
+    std::string line;
+    if (!in || !std::getline(in, line) || line != kIndexHeader) return;
+
+    // session <n> <next file>
+    // page <file> <w> <h> <nextY> <used area> <shelves> (<y> <h> <x>)...
+    // slots
+    // <key> \t <mtime> <page> <x> <y> <w> <h> <last used>
+    int session = 0;
+    int nextFile = 0;
+    std::string word;
+    if (!std::getline(in, line)) return;
+    std::istringstream(line) >> word >> session >> nextFile;
+    if (word != "session") return;
+
+    std::vector<Page> pages;
+    while (std::getline(in, line) && line != "slots") {
+      std::istringstream fields(line);
+      Page page;
+      int width, height, shelfCount;
+      if (!(fields >> word >> page.file >> width >> height >> page.nextY >>
+            page.usedArea >> shelfCount) ||
+          word != "page" || page.file < 0 || page.file >= nextFile ||
+          width <= 0 || height <= 0 || shelfCount < 0) {
+        return;
+      }
+      page.size = QSize(width, height);
+      page.onDisk = true;
+      for (int i = 0; i < shelfCount; i++) {
+        Shelf shelf;
+        if (!(fields >> shelf.y >> shelf.height >> shelf.x)) return;
+        page.shelves.push_back(shelf);
+      }
+      pages.push_back(std::move(page));
+    }
+
+    std::unordered_map<std::string, Slot> slots;
+    size_t idle = 0;
+    while (std::getline(in, line)) {
+      std::istringstream fields(line);
+      std::string key;
+      Slot slot;
+      int x, y, w, h;
+      if (!std::getline(fields, key, '\t') ||
+          !(fields >> slot.mtime >> slot.page >> x >> y >> w >> h >> slot.lastUsed) ||
+          slot.page < 0 || slot.page >= static_cast<int>(pages.size())) {
+        return;
+      }
+      slot.rect = QRect(x, y, w, h);
+      if (!QRect(QPoint(0, 0), pages[slot.page].size).contains(slot.rect)) return;
+      if (session - slot.lastUsed >= kIdleSessions) {
+        // Left as dead area for the next compaction.
+        idle++;
+        continue;
+      }
+      pages[slot.page].liveArea += areaOf(slot.rect);
+      slots[key] = slot;
+    }
+    m_pages = std::move(pages);
+    m_slots = std::move(slots);
+    m_session = session + 1;
+    m_nextFile = nextFile;
+    TB_LOG_DEBUG(General, "Icon cache: {} variants on {} pages, {} idle dropped",
+                 m_slots.size(), m_pages.size(), idle);
+    // Records the new session, and compacts if the idle ones made that
+    // worthwhile.
+    scheduleSave();
+  }
+
+  // Coalesces every change in one event-loop iteration into a single write.
+  void scheduleSave() {
+    if (m_saveQueued || m_directory.empty()) return;
+    m_saveQueued = tasks::postToGui([this]() {
+      m_saveQueued = false;
+      save();
+    });
+  }
+
+  // Snapshots the dirty pages and the index for the writer. Snapshots from
+  // several saves merge, newest page image winning, so whichever write runs
+  // last always puts a consistent state on disk.
+  void save() {
+    if (shouldCompact()) compact();
+    std::string index = std::format("{}\nsession {} {}\n", kIndexHeader,
+                                    m_session, m_nextFile);
+    std::unordered_set<int> liveFiles;
+    for (const auto &page : m_pages) {
+      index += std::format("page {} {} {} {} {} {}", page.file, page.size.width(),
+                           page.size.height(), page.nextY, page.usedArea,
+                           page.shelves.size());
+      for (const auto &shelf : page.shelves) {
+        index += std::format(" {} {} {}", shelf.y, shelf.height, shelf.x);
+      }
+      index += '\n';
+      liveFiles.insert(page.file);
+    }
+    index += "slots\n";
+    for (const auto &[key, slot] : m_slots) {
+      index += std::format("{}\t{} {} {} {} {} {} {}\n", key, slot.mtime,
+                           slot.page, slot.rect.x(), slot.rect.y(),
+                           slot.rect.width(), slot.rect.height(), slot.lastUsed);
+    }
+    bool post = false;
+    {
+      std::lock_guard lock(m_pending.mutex);
+      std::erase_if(m_pending.pages, [&](const auto &entry) {
+        return !liveFiles.contains(entry.first);
+      });
+      for (auto &page : m_pages) {
+        if (!page.dirty) continue;
+        // Implicitly shared; later drawing on the GUI thread detaches.
+        m_pending.pages[page.file] = page.image;
+        page.dirty = false;
+        page.onDisk = true;
+      }
+      m_pending.index = std::move(index);
+      m_pending.liveFiles = std::move(liveFiles);
+      m_pending.directory = m_directory;
+      post = !std::exchange(m_pending.posted, true);
+    }
+    if (post) tasks::post([this]() { write(); });
+  }
+
+  // Runs on the pool.
+  void write() {
+    std::lock_guard writing(m_writeMutex);
+    std::unordered_map<int, QImage> pages;
+    std::unordered_set<int> liveFiles;
+    std::string index;
+    std::filesystem::path directory;
+    int generation;
+    {
+      std::lock_guard lock(m_pending.mutex);
+      generation = m_pending.generation;
+      pages = std::move(m_pending.pages);
+      m_pending.pages.clear();
+      liveFiles = m_pending.liveFiles;
+      index = std::move(m_pending.index);
+      m_pending.index.clear();
+      directory = m_pending.directory;
+      m_pending.posted = false;
+    }
+    if (index.empty()) return; // cleared since
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    for (auto it = pages.begin(); it != pages.end();) {
+      const auto path = pagePath(directory, it->first);
+      auto tmp = path;
+      tmp += ".tmp";
+      ec.clear();
+      if (it->second.save(QString::fromStdWString(tmp.wstring()), "PNG")) {
+        std::filesystem::rename(tmp, path, ec);
+      } else {
+        ec = std::make_error_code(std::errc::io_error);
+      }
+      if (ec) {
+        TB_LOG_WARN(General, "Could not write icon atlas {}", path.string());
+        std::error_code removeEc;
+        std::filesystem::remove(tmp, removeEc);
+        requeue(generation, std::move(pages), std::move(index),
+                std::move(liveFiles), directory);
+        return;
+      }
+      it = pages.erase(it);
+    }
+    // The index goes after the pages so it never points at pages not yet
+    // written, and repacked pages have new files, so the old index stays
+    // valid until it is replaced.
+    const auto path = directory / "index.txt";
+    auto tmp = path;
+    tmp += ".tmp";
+    {
+      std::ofstream out(tmp, std::ios::trunc);
+      out << index;
+      if (!out) ec = std::make_error_code(std::errc::io_error);
+    }
+    if (!ec) std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+      TB_LOG_WARN(General, "Could not write icon index {}", path.string());
+      requeue(generation, {}, std::move(index), std::move(liveFiles), directory);
+      return;
+    }
+
+    // Only now is nothing pointing at pages a compaction replaced.
+    for (std::filesystem::directory_iterator it(directory, ec), end;
+         !ec && it != end; it.increment(ec)) {
+      int file = -1;
+      const auto name = it->path().filename().string();
+      if (std::sscanf(name.c_str(), "atlas-%d.png", &file) == 1 &&
+          name == pagePath({}, file).string() && !liveFiles.contains(file)) {
+        std::error_code removeEc;
+        std::filesystem::remove(it->path(), removeEc);
+      }
+    }
+  }
+
+  // Puts back what a failed write() left unwritten, unless clear() ran
+  // since. Snapshots queued meanwhile are newer and win; whichever save
+  // comes next posts a write that retries the rest.
+  void requeue(int generation, std::unordered_map<int, QImage> pages,
+               std::string index, std::unordered_set<int> liveFiles,
+               const std::filesystem::path &directory) {
+    std::lock_guard lock(m_pending.mutex);
+    if (m_pending.generation != generation) return;
+    const bool newer = !m_pending.index.empty();
+    for (auto &[file, image] : pages) {
+      if (newer && !m_pending.liveFiles.contains(file)) continue;
+      m_pending.pages.try_emplace(file, std::move(image));
+    }
+    if (!newer) {
+      m_pending.index = std::move(index);
+      m_pending.liveFiles = std::move(liveFiles);
+      m_pending.directory = directory;
+    }
+  }
+
+  std::filesystem::path m_directory;
+  bool m_loaded = false;
+  bool m_saveQueued = false;
+  struct {
+    std::mutex mutex;
+    std::unordered_map<int, QImage> pages; // by file
+    std::unordered_set<int> liveFiles;
+    std::string index;
+    std::filesystem::path directory;
+    bool posted = false;
+    int generation = 0; // bumped by clear()
+  } m_pending;
+  std::mutex m_writeMutex;
+  int m_session = 0;
+  int m_nextFile = 0;
+  std::vector<Page> m_pages;
+  std::unordered_map<std::string, Slot> m_slots;
+  std::unordered_map<std::string, QPixmap> m_pixmaps;
+  std::unordered_map<std::string, qint64> m_mtimes;
+};
+
+class AtlasIconEngine : public QIconEngine {
+public:
+  AtlasIconEngine(QString source, QColor blend)
+      : m_source(std::move(source)), m_blend(blend) {}
+
+  void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode,
+             QIcon::State state) override {
+    const qreal dpr = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+    painter->drawPixmap(rect, scaledPixmap(rect.size(), mode, state, dpr));
+  }
+
+  QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state) override {
+    return scaledPixmap(size, mode, state, 1.0);
+  }
+
+  QPixmap scaledPixmap(const QSize &size, QIcon::Mode mode, QIcon::State,
+                       qreal scale) override {
+    return Atlas::instance().pixmap(m_source, qMax(size.width(), size.height()),
+                                    scale, m_blend, mode);
+  }
+
+  QSize actualSize(const QSize &size, QIcon::Mode, QIcon::State) override {
+    const int side = qMax(size.width(), size.height());
+    return QSize(side, side);
+  }
+
+  QIconEngine *clone() const override { return new AtlasIconEngine(m_source, m_blend); }
+  QString key() const override { return QStringLiteral("toon_boom_atlas"); }
+  bool isNull() override { return m_source.isEmpty(); }
+
+private:
+  QString m_source;
+  QColor m_blend;
+};
+
+using LoadImage_t = QIcon *(*)(AC_Manager *, QIcon *, const QString &,
+                               const QColor &, bool);
+LoadImage_t loadImageOriginal = nullptr;
+
+// loadImage returns a QIcon by value, so MSVC passes the return buffer
+// after `this` and expects it back.
+QIcon *loadImageHook(AC_Manager *self, QIcon *result, const QString &name,
+                     const QColor &blend, bool useGeneric) {
+  static auto &served = metrics::counter("icons.hooked_loads");
+  // Harmony's blending is its own; leave blended icons to it, and leave
+  // missing images to its generic-image fallback.
+  if (!blend.isValid() || blend.alpha() == 0) {
+    const auto path = self->findImage(name);
+    if (!path.isEmpty()) {
+      served.add();
+      return new (result) QIcon(icon(path));
+    }
+  }
+  return loadImageOriginal(self, result, name, blend, useGeneric);
+}
+
+} // namespace
+
+QIcon icon(const QString &sourcePath, const QColor &blend) {
+  return QIcon(new AtlasIconEngine(sourcePath, blend));
+}
+
+QPixmap pixmap(const QString &sourcePath, int logicalSize, qreal devicePixelRatio,
+               const QColor &blend, QIcon::Mode mode) {
+  return Atlas::instance().pixmap(sourcePath, logicalSize, devicePixelRatio,
+                                  blend, mode);
+}
+
+void setCacheDirectory(const std::filesystem::path &directory) {
+  Atlas::instance().setDirectory(directory);
+}
+
+void clear() { Atlas::instance().clear(); }
+
+bool installImageHook(AC_Manager *manager) {
+  if (!manager || g_hookDisabled) return false;
+  static const bool hooked = toon_boom_module::hooks::hook_virtual(
+      manager, kLoadImageSlot, &loadImageHook, &loadImageOriginal,
+      "AC_Manager::loadImage");
+  return hooked;
+}
+
+} // namespace util::icons
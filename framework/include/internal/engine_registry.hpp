@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QtCore/QPointer>
+#include <QtScript/QScriptEngine>
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../public/hooks/toon_boom_hooks.hpp"
+
+namespace toon_boom_module::hooks {
+
+// Tracks every live QScriptEngine Harmony has handed us and which hooks have
+// already run on each of them.
+//
+// Engines are held through QPointer and dropped from the table on
+// QObject::destroyed, so the registry never extends an engine's lifetime.
+// Each (engine, hook token) pair runs at most once: an SCR_ScriptManager that
+// is rebuilt around an engine we have already initialized costs a table
+// lookup, and hooks registered after an engine was created are replayed to it.
+class EngineRegistry {
+public:
+  // Starts tracking engine. Returns false if it was already tracked.
+  bool track(QScriptEngine *engine);
+
+  // Runs every registered hook that has not yet run on engine: plain hooks
+  // inline, deferred hooks posted to the engine's event loop, lazy globals as
+  // accessors. Each run is timed and slow hooks are reported. Must be called
+  // on engine's thread.
+  void apply_pending(QScriptEngine *engine);
+
+  // Queues apply_pending on the thread of every live engine. Always posted,
+  // never run inline, since registration commonly happens from DllMain.
+  void replay_to_live_engines();
+
+  std::vector<QScriptEngine *> live_engines() const;
+
+private:
+  struct EngineState {
+    QPointer<QScriptEngine> engine;
+    std::unordered_set<ScriptEngine_hook_token_t> applied;
+  };
+
+  void forget(QScriptEngine *engine);
+
+  mutable std::mutex m_mutex;
+  std::unordered_map<QScriptEngine *, EngineState> m_engines;
+};
+
+EngineRegistry &script_engines();
+
+} // namespace toon_boom_module::hooks
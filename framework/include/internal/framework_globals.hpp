@@ -0,0 +1,9 @@
+#pragma once
+
+namespace toon_boom_module::hooks {
+
+// Registers the framework's own script globals (`frameworkMetrics`, ...) as
+// lazy globals on every engine. Called once from hookInit.
+void install_framework_globals();
+
+} // namespace toon_boom_module::hooks
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../public/hooks/toon_boom_hooks.hpp"
+
+namespace toon_boom_module::hooks {
+
+enum HookFlags : unsigned {
+  // Run from the engine thread's event loop instead of inside the
+  // SCR_ScriptManager constructor.
+  kHookDeferred = 1u << 0,
+  // Install global_name as an accessor that calls factory on first read.
+  kHookLazyGlobal = 1u << 1,
+};
+
+struct HookEntry {
+  ScriptEngine_hook_t hook{};
+  ScriptEngine_property_factory_t factory{};
+  std::string global_name;
+  int priority{};
+  unsigned flags{};
+  ScriptEngine_hook_token_t token{};
+};
+
+// One published generation of the registry. Never mutated after it becomes
+// visible through HookRegistry::m_current.
+struct HookSnapshot {
+  std::vector<HookEntry> entries;
+  HookSnapshot *next_retired{};
+};
+
+// Copy-on-write registry of ScriptEngine hooks.
+//
+// Writers build a new HookSnapshot and publish it with a CAS on m_current, so
+// concurrent add/remove calls never block each other. Readers only bump an
+// in-flight counter, load the current snapshot and iterate it; they never
+// take a lock or retry, which keeps firing hooks wait-free.
+//
+// Replaced snapshots go onto a retired list and are freed by a later writer
+// once it observes no in-flight readers. A reader that loaded a snapshot
+// before it was replaced is counted in m_active_readers until it finishes, so
+// it can never observe a freed snapshot.
+class HookRegistry {
+public:
+  class ReadGuard {
+  public:
+    explicit ReadGuard(const HookRegistry &registry);
+    ~ReadGuard();
+    ReadGuard(const ReadGuard &) = delete;
+    ReadGuard &operator=(const ReadGuard &) = delete;
+
+    const HookEntry *begin() const { return m_snapshot->entries.data(); }
+    const HookEntry *end() const {
+      return m_snapshot->entries.data() + m_snapshot->entries.size();
+    }
+    std::size_t size() const { return m_snapshot->entries.size(); }
+    bool empty() const { return m_snapshot->entries.empty(); }
+
+  private:
+    const HookRegistry &m_registry;
+    const HookSnapshot *m_snapshot;
+  };
+
+  HookRegistry();
+  ~HookRegistry();
+  HookRegistry(const HookRegistry &) = delete;
+  HookRegistry &operator=(const HookRegistry &) = delete;
+
+  // Assigns entry.token and publishes it. Higher priorities fire first; equal
+  // priorities fire in registration order. Returns 0 if the entry has neither
+  // a hook nor a factory.
+  ScriptEngine_hook_token_t add(HookEntry entry);
+
+  // Returns false if the token is unknown or was already removed.
+  bool remove(ScriptEngine_hook_token_t token);
+
+  ReadGuard read() const { return ReadGuard(*this); }
+
+private:
+  void retire(HookSnapshot *snapshot);
+  void push_retired(HookSnapshot *first, HookSnapshot *last);
+  void reclaim();
+
+  std::atomic<HookSnapshot *> m_current;
+  mutable std::atomic<std::size_t> m_active_readers{0};
+  std::atomic<HookSnapshot *> m_retired{nullptr};
+  std::atomic<ScriptEngine_hook_token_t> m_next_token{1};
+};
+
+// Process-wide registry backing Add_ScriptEngine_hook and friends.
+HookRegistry &script_engine_hooks();
+
+} // namespace toon_boom_module::hooks
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <MinHook.h>
+#include <cstdint>
+
+#include "../public/toon_boom/ext/flight_recorder.hpp"
+#include "../public/toon_boom/ext/log.hpp"
+
+namespace toon_boom_module::hooks {
+
+// Hooks the function behind vtable slot `slot` of object with MinHook, so
+// every object sharing that implementation is affected. MSVC x64 passes
+// `this` in the first argument register (and a by-value return buffer in
+// the second), so hook can be a free function taking them explicitly.
+//
+// Returns false, leaving *original untouched, when MinHook is unavailable,
+// e.g. when the framework was not loaded through the injector.
+template <typename Fn>
+bool hook_virtual(void *object, int slot, Fn hook, Fn *original,
+                  const char *what) {
+  auto *target = (*reinterpret_cast<void ***>(object))[slot];
+  auto status = MH_CreateHook(target, reinterpret_cast<LPVOID>(hook),
+                              reinterpret_cast<LPVOID *>(original));
+  if (status == MH_OK) status = MH_EnableHook(target);
+  util::recorder::record(util::recorder::Kind::HookStatus, what,
+                         reinterpret_cast<std::uintptr_t>(target), status);
+  if (status != MH_OK) {
+    TB_LOG_DEBUG(Hooks, "Could not hook {}: {}", what,
+                 MH_StatusToString(status));
+    return false;
+  }
+  return true;
+}
+
+} // namespace toon_boom_module::hooks
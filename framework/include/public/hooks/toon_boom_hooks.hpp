@@ -1,6 +1,7 @@
 #pragma once
 #include <MinHook.h>
 #include <QtScript/QScriptEngine>
+#include <cstdint>
 
 typedef QScriptEngine* (__stdcall *SCR_ScriptRuntime_getEngine_t)(void*);
 
@@ -11,5 +12,26 @@ QScriptEngine* SCR_ScriptRuntime_getEngine(void*);
 
 typedef void (__stdcall *ScriptEngine_hook_t)(QScriptEngine*);
 
+typedef QScriptValue (__stdcall *ScriptEngine_property_factory_t)(QScriptEngine*);
+
+// Opaque handle returned by Add_ScriptEngine_hook_ex. 0 is never a valid token.
+typedef std::uint64_t ScriptEngine_hook_token_t;
+
+// Registers a hook with priority 0. Safe to call from any thread.
 __declspec(dllexport) void Add_ScriptEngine_hook(ScriptEngine_hook_t hook);
-__declspec(dllexport) BOOL hookInit();
\ No newline at end of file
+// Registers a hook; higher priorities fire first, equal priorities fire in
+// registration order. Returns 0 if hook is null.
+// Engines that are already alive get the hook replayed on their own thread
+// from the event loop; every hook runs at most once per engine.
+__declspec(dllexport) ScriptEngine_hook_token_t Add_ScriptEngine_hook_ex(ScriptEngine_hook_t hook, int priority);
+// Like Add_ScriptEngine_hook_ex, but the hook is posted to the engine thread's
+// event loop and runs after Harmony's SCR_ScriptManager constructor returns,
+// so it does not add to scene-open or script-manager creation time.
+__declspec(dllexport) ScriptEngine_hook_token_t Add_ScriptEngine_hook_deferred(ScriptEngine_hook_t hook, int priority);
+// Defines a global named `name` on every engine. factory runs the first time a
+// script reads the global; until then the only cost is installing an accessor.
+__declspec(dllexport) ScriptEngine_hook_token_t Add_ScriptEngine_lazy_global(const char* name, ScriptEngine_property_factory_t factory, int priority);
+// Deregisters a hook. Returns false if the token is unknown. A hook that is
+// firing concurrently on another thread is allowed to finish.
+__declspec(dllexport) bool Remove_ScriptEngine_hook(ScriptEngine_hook_token_t token);
+__declspec(dllexport) BOOL hookInit();
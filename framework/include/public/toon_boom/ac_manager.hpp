@@ -32,6 +32,11 @@
 #include <QtXml/QDomElement>
 #include <vector>
 
+#include "./ext/dispatch.hpp"
+#include "./ext/metrics.hpp"
+#include "./ext/responders.hpp"
+#include "./ext/validation.hpp"
+
 
 // Forward declarations
 class AC_Manager;
@@ -367,7 +372,8 @@ public:
 class AC_ResponderBase : public AC_Responder {
 public:
   AC_ResponderBase(const QString &identity, QObject* obj, AC_Manager *manager = nullptr)
-      : m_identity(identity), m_object(obj), m_manager(manager) {
+      : m_identity(identity), m_object(obj), m_manager(manager),
+        m_atom(util::responders::intern(identity)) {
         
     }
 
@@ -387,6 +393,8 @@ public:
   bool acceptsSelectionResponder() override { return false; }
 
   const QString &responderIdentity() const override { return m_identity; }
+  /// The interned responderIdentity(); see util::responders.
+  util::responders::Atom responderAtom() const { return m_atom; }
   const QString &responderDescription() const override { return m_description; }
   void setResponderDescription(const QString &desc) override {
     m_description = desc;
@@ -396,23 +404,78 @@ public:
   AC_Responder *proxyResponder() override { return this; }
 
   AC_Result perform(AC_ActionInfo *info) override {
+    static auto &performed = util::metrics::counter("actions.performed");
+    static auto &latency = util::metrics::histogram("actions.perform_ns");
+    performed.add();
+    util::metrics::ScopedTimer timer(latency);
     return info->invokeOnQObject(m_object);
   }
   AC_Result performDownToChildren(AC_ActionInfo *info) override {
     return AC_Result::Handled;
   }
 
+  /**
+   * @brief Runs the slot named signature, as written in toolbar XML (e.g.
+   * "onActionResetCounter()"), through util::actions::DispatchTable.
+   *
+   * perform() cannot do this itself: AC_ActionInfo does not expose its slot
+   * name in this ABI, so actions from Harmony still resolve by name through
+   * invokeOnQObject(). Use this for actions the extension fires rapidly
+   * itself, e.g. while scrubbing. NotHandled when this responder has no
+   * such slot; info is only passed on to it, never used to pick the slot.
+   */
+  AC_Result performAction(std::string_view signature,
+                          AC_ActionInfo *info = nullptr) {
+    static auto &performed = util::metrics::counter("actions.performed");
+    static auto &latency = util::metrics::histogram("actions.perform_ns");
+    performed.add();
+    util::metrics::ScopedTimer timer(latency);
+    if (m_object && util::actions::DispatchTable::forMetaObject(
+                        m_object->metaObject())
+                        .invoke(m_object, signature, info)) {
+      return AC_Result::Handled;
+    }
+    return AC_Result::NotHandled;
+  }
+
   AC_Result handleEvent(QEvent * /*event*/) override {
     return AC_Result::Handled;
   }
   void setActionManager(AC_Manager *manager) { m_manager = manager; }
 
 protected:
+  /**
+   * @brief Applies the cached validation state for key to info.
+   *
+   * For use inside `on...Validate` slots. compute(util::actions::ActionState&)
+   * only runs on the first validation after invalidateActions().
+   */
+  template <typename F>
+  void validateCached(AC_ActionInfo *info, std::string_view key, F &&compute) {
+    auto state = m_validation.get(key, std::forward<F>(compute));
+    info->setEnabled(state.enabled);
+    if (state.visible) {
+      info->setVisible(*state.visible);
+    }
+  }
+
+  /**
+   * @brief Drops cached validation and schedules a coalesced revalidation.
+   *
+   * Call whenever state read by the validate slots changes.
+   */
+  void invalidateActions() {
+    m_validation.clear();
+    util::actions::scheduleRevalidation(m_manager);
+  }
+
   QString m_identity;
   QString m_description;
   AC_Manager *m_manager;
 private:
   QObject* m_object;
+  util::actions::ValidationCache m_validation;
+  util::responders::Atom m_atom;
 };
 
 /**
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QtCore/QObject>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+class AC_ActionInfo;
+
+/**
+ * @brief Per-class slot lookup tables for dispatching actions by slot name.
+ *
+ * Invoking a slot by name makes Qt normalize the signature and search the
+ * metaobject's methods on every call. DispatchTable does that search once
+ * per QMetaObject, hashing every method's signature (e.g.
+ * `onActionResetCounter()`, as written in toolbar XML), so later calls are
+ * a hash probe and a QMetaObject::metacall() with no allocation.
+ *
+ * Slots that are hot enough to skip qt_metacall too can register a direct
+ * member-function thunk at static-initialization time:
+ *
+ * @code
+ * static const bool kBound =
+ *     util::actions::bindSlot<&CounterWidget::onActionIncrementCounter>(
+ *         "onActionIncrementCounter()");
+ * @endcode
+ *
+ * Thunks apply to objects whose most derived metaobject is the one they were
+ * bound on. GUI thread only.
+ */
+
+namespace util::actions {
+
+class DispatchTable {
+public:
+  using Thunk = void (*)(QObject *object, AC_ActionInfo *info);
+
+  /// Built on first use and kept for the life of the process.
+  static DispatchTable &forMetaObject(const QMetaObject *metaObject);
+
+  /// Calls the slot with this signature on object, which must be an
+  /// instance of this table's class. Only slots taking no arguments or a
+  /// single AC_ActionInfo* are indexed; false for any other signature.
+  bool invoke(QObject *object, std::string_view signature,
+              AC_ActionInfo *info) const;
+
+  bool contains(std::string_view signature) const;
+
+  void setThunk(std::string_view signature, Thunk thunk);
+
+private:
+  struct Entry {
+    std::uint64_t hash;
+    std::string signature;
+    int methodIndex;
+    int parameterCount;
+    Thunk thunk;
+  };
+
+  explicit DispatchTable(const QMetaObject *metaObject);
+  const Entry *find(std::string_view signature) const;
+
+  const QMetaObject *m_metaObject;
+  std::vector<Entry> m_entries; // sorted by hash
+};
+
+namespace detail {
+template <typename> struct MemberOf;
+template <typename C, typename R, typename... Args>
+struct MemberOf<R (C::*)(Args...)> {
+  using Class = C;
+  static constexpr bool takesInfo =
+      sizeof...(Args) == 1 && (std::is_same_v<Args, AC_ActionInfo *> && ...);
+  static_assert(sizeof...(Args) == 0 || takesInfo,
+                "action slots take no arguments or an AC_ActionInfo*");
+};
+} // namespace detail
+
+/// Binds a direct call to Slot for its class's actions named signature.
+/// Returns true so it can initialize a static.
+template <auto Slot> bool bindSlot(std::string_view signature) {
+  using Traits = detail::MemberOf<decltype(Slot)>;
+  using Class = typename Traits::Class;
+  DispatchTable::forMetaObject(&Class::staticMetaObject)
+      .setThunk(signature, [](QObject *object, AC_ActionInfo *info) {
+        auto *self = static_cast<Class *>(object);
+        if constexpr (Traits::takesInfo) {
+          (self->*Slot)(info);
+        } else {
+          (void)info;
+          (self->*Slot)();
+        }
+      });
+  return true;
+}
+
+} // namespace util::actions
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Always-on record of recent framework events.
+ *
+ * A fixed ring of the last kCapacity events (signature resolves, MinHook
+ * statuses, engine creation, hook timings, failures) kept in memory for the
+ * life of the process. Recording claims a slot with one atomic increment and
+ * publishes it with a per-slot sequence number, so it never locks or
+ * allocates and is cheap enough to leave enabled in release builds.
+ *
+ * The framework dumps the ring to a file when one of its hook failure paths
+ * triggers; scripts can dump it with `frameworkFlightRecorder.dump()`.
+ */
+
+namespace util::recorder {
+
+enum class Kind : std::uint8_t {
+  Note,
+  Resolve,
+  HookStatus,
+  Engine,
+  Timing,
+  Failure,
+};
+
+struct Event {
+  static constexpr std::size_t kLabelCapacity = 26;
+
+  std::int64_t timestamp; ///< system_clock ticks
+  std::uint64_t a;        ///< meaning depends on kind, e.g. an address
+  std::uint64_t b;        ///< e.g. a status code or duration in us
+  std::uint32_t threadId;
+  Kind kind;
+  std::uint8_t length;
+  char label[kLabelCapacity]; ///< not null-terminated; see length
+};
+static_assert(sizeof(Event) == 56, "an event plus its sequence is 64 bytes");
+
+constexpr std::size_t kCapacity = 1024; // power of two
+
+/// label is truncated to Event::kLabelCapacity bytes.
+void record(Kind kind, std::string_view label, std::uint64_t a = 0,
+            std::uint64_t b = 0);
+
+/// The events currently in the ring, oldest first. Slots being overwritten
+/// while this runs are skipped.
+std::vector<Event> events();
+
+/// Writes events() as text, headed by reason. Returns false if the file
+/// could not be written.
+bool dump(const std::filesystem::path &path, std::string_view reason);
+
+/// dump() to `%TEMP%/toon-boom-extension-framework/flight-<pid>.log`,
+/// replacing the previous dump from this process. Returns the path written,
+/// or an empty path on failure.
+std::filesystem::path dumpToDefault(std::string_view reason);
+
+} // namespace util::recorder
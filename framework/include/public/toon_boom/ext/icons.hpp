@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QtGui/QColor>
+#include <QtGui/QIcon>
+#include <QtGui/QPixmap>
+#include <QtCore/QString>
+#include <filesystem>
+
+class AC_Manager;
+
+/**
+ * @brief Rasterized icon cache shared by every toolbar and view.
+ *
+ * Each variant of an icon (source file, logical size, device pixel ratio,
+ * blend colour, icon mode) is rendered once, packed into 1024x1024 atlas
+ * pages and written to disk under %LOCALAPPDATA%, so SVGs are not
+ * re-rendered each time a toolbar is rebuilt, the DPI changes or Harmony
+ * restarts. Disk entries are dropped when their source file's mtime
+ * changes or after 30 sessions without a lookup. A page is only decoded
+ * when one of its variants is first needed, and pages are repacked once
+ * replaced or dropped variants take up a third of them.
+ *
+ * icon() returns a QIcon whose pixmaps come from the atlas. Once
+ * installImageHook() has run (registerToolbar() does this), icons that
+ * Harmony loads through AC_Manager::loadImage() for toolbars and menus come
+ * from it too. Set TB_EXT_ICON_CACHE=0 to turn the hook off.
+ *
+ * Rendering and lookups are GUI thread only; pages are written to disk on
+ * the framework thread pool.
+ */
+
+namespace util::icons {
+
+/// A QIcon for sourcePath backed by the atlas. blend, when valid and not
+/// fully transparent, tints the icon's opaque pixels.
+QIcon icon(const QString &sourcePath, const QColor &blend = QColor());
+
+/// One variant, rendering it if it is not cached yet.
+QPixmap pixmap(const QString &sourcePath, int logicalSize, qreal devicePixelRatio,
+               const QColor &blend = QColor(), QIcon::Mode mode = QIcon::Normal);
+
+/// Defaults to %LOCALAPPDATA%/toon-boom-extension-framework/icons. Takes
+/// effect before the first lookup.
+void setCacheDirectory(const std::filesystem::path &directory);
+
+/// Drops every cached variant, in memory and on disk.
+void clear();
+
+/// Makes AC_Manager::loadImage() answer from the atlas. Once per process;
+/// returns whether the hook is in place.
+bool installImageHook(AC_Manager *manager);
+
+} // namespace util::icons
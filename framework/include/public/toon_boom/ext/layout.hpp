@@ -1,19 +1,77 @@
 #pragma once
 #include "../PLUG_Services.hpp"
 #include "../toon_boom_layout.hpp"
+#include "./icons.hpp"
+#include "./log.hpp"
+#include "./metrics.hpp"
+#include "./toolbar_def.hpp"
+#include "./trace.hpp"
 #include "./util.hpp"
 #include "QtXml/qdom.h"
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
 #include <QtCore/Qt>
 #include <QtWidgets/QWidget>
+#include <cstddef>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <string>
 #include <type_traits>
+#include <typeinfo>
 
 using namespace util;
 template <typename T>
 concept isQWidget = std::is_base_of<QWidget, T>::value;
 
+namespace util::layout {
+/**
+ * @brief Keeps the widgets of destroyed views alive for the next view of the
+ * same type.
+ *
+ * Widgets are held hidden and unparented with their state intact, most
+ * recently released first. When the total cost passes the budget the least
+ * recently released widgets are deleted. Views opt in through
+ * TUWidgetLayoutViewBase::pooledWidgetCost(). GUI thread only.
+ */
+class WidgetPool {
+public:
+  static constexpr std::size_t kDefaultBudget = std::size_t{64} << 20;
+
+  static WidgetPool &instance();
+
+  /// Evicts immediately if the pool is now over budget. 0 disables pooling.
+  void setBudget(std::size_t bytes);
+  std::size_t budget() const { return m_budget; }
+  std::size_t used() const { return m_used; }
+
+  /// Takes ownership of an unparented widget. Widgets costing more than the
+  /// whole budget are deleted straight away.
+  void release(const std::string &key, QWidget *widget, std::size_t cost);
+
+  /// The most recently released live widget for key, or nullptr. The caller
+  /// owns it again.
+  QWidget *acquire(const std::string &key);
+
+  /// Deletes every pooled widget.
+  void clear();
+
+private:
+  struct Entry {
+    std::string key;
+    QPointer<QWidget> widget;
+    std::size_t cost;
+  };
+
+  WidgetPool() = default;
+  void evictToBudget();
+
+  std::list<Entry> m_entries; // most recently released first
+  std::size_t m_budget = kDefaultBudget;
+  std::size_t m_used = 0;
+};
+} // namespace util::layout
+
 /**
  * @brief Simple base class for implementing TULayoutView with a QWidget, with
  all the ugly parts abstracted away.
@@ -30,7 +88,20 @@ public:
     m_widget = widget;
     m_parentConnected = nullptr;
   };
-  virtual ~TUWidgetLayoutViewBase() {};
+  virtual ~TUWidgetLayoutViewBase() {
+    // The unparenting handler captures this view; it must not outlive it.
+    QObject::disconnect(m_parentConnection);
+    // Drops every connection made with viewContext() as the context, before
+    // the widget can reach another view through the pool.
+    m_viewContext.reset();
+    if (!m_widget || m_poolCost == 0) return;
+    if constexpr (requires(T &w) { w.onReleasedToPool(); }) {
+      m_widget->onReleasedToPool();
+    }
+    m_widget->setParent(nullptr);
+    layout::WidgetPool::instance().release(m_poolKey, m_widget.data(),
+                                           m_poolCost);
+  };
   virtual void triggerMenuChanged() override {}
   QWidget *widget() override {
     return reinterpret_cast<QWidget *>(static_cast<TULayoutView *>(this));
@@ -77,8 +148,58 @@ protected:
   virtual void onParentDisconnect() {}
   virtual void afterWidgetCreated() {}
 
+  /**
+   * @brief Opts this view's widget into layout::WidgetPool.
+   *
+   * Return a rough estimate of the widget's memory in bytes to have it kept
+   * when the view is destroyed and handed to the next view of the same type
+   * instead of calling createWidget(). 0, the default, never pools.
+   *
+   * A pooled widget whose type has `void onReleasedToPool()` gets it called
+   * just before it is pooled, e.g. to stop timers or drop caches.
+   *
+   * A pooled widget outlives its view, so any connection that calls into
+   * the view must use viewContext() as its receiver or context. One that
+   * uses the widget or a child instead would outlive the view, dangling.
+   */
+  virtual std::size_t pooledWidgetCost() const { return 0; }
+
+  /// Called instead of createWidget() + afterWidgetCreated() when m_widget
+  /// came from the pool. Connections made through the old view's
+  /// viewContext() are gone; anything else set up on the widget, including
+  /// other connections, is still in place. The default runs
+  /// afterWidgetCreated() again, which suits views that connect only
+  /// through viewContext().
+  virtual void onWidgetReused() { afterWidgetCreated(); }
+
+  /// A QObject that lives exactly as long as this view, for use as the
+  /// receiver or context of connections that call into it. TULayoutView is
+  /// not a QObject, so it cannot be one itself.
+  QObject *viewContext() {
+    if (!m_viewContext) m_viewContext = std::make_unique<QObject>();
+    return m_viewContext.get();
+  }
+
   void ensureWidget() {
     if (!m_widget) {
+      // Captured now because the destructor cannot call overrides.
+      m_poolCost = pooledWidgetCost();
+      if (m_poolCost > 0) {
+        m_poolKey = typeid(*this).name();
+        if (auto *pooled = layout::WidgetPool::instance().acquire(m_poolKey)) {
+          static auto &reused = metrics::counter("layout.views_reused");
+          reused.add();
+          // Keyed by the view's dynamic type, so this is always a T.
+          m_widget = static_cast<T *>(pooled);
+          onWidgetReused();
+          return;
+        }
+      }
+      TB_TRACE_SCOPE("layout", "createWidget");
+      static auto &created = metrics::counter("layout.views_created");
+      static auto &latency = metrics::histogram("layout.create_widget_ns");
+      created.add();
+      metrics::ScopedTimer timer(latency);
       m_widget = createWidget();
       afterWidgetCreated();
     }
@@ -99,12 +220,12 @@ protected:
     if (!parent || !m_widget)
       return;
     m_parentConnected = parent;
-    QObject::connect(
+    QObject::disconnect(m_parentConnection);
+    m_parentConnection = QObject::connect(
         parent, &QObject::destroyed, m_widget.data(),
         [this]() {
-          debug::out << "[parent destroyed] Unparenting widget to prevent "
-                       "cross-DLL heap deletion"
-                    << std::endl;
+          TB_LOG_DEBUG(Layout, "[parent destroyed] Unparenting widget to "
+                               "prevent cross-DLL heap deletion");
           if (m_widget) {
             m_widget->setParent(nullptr);
           }
@@ -115,37 +236,53 @@ protected:
   }
   /**
    * @brief convenience method to register a toolbar from an xml element
+   *
+   * Compiles element through util::toolbar::compile(); prefer the Definition
+   * overload with a definition compiled once up front.
    */
   bool registerToolbar(const QDomElement &element, const QString &name) {
-    auto am = PLUG_Services::getActionManager();
-    QDomElement docEl = element;
-    if (docEl.tagName() == "toolbars") {
-      docEl = docEl.firstChildElement();
-    }
-    if (am) {
+    auto def = toolbar::compile(element);
+    return def && registerToolbar(*def, name);
+  }
+
+  /**
+   * @brief Registers a compiled toolbar with AC_Manager (once per process)
+   * and makes it this view's toolbar.
+   */
+  bool registerToolbar(const toolbar::Definition &def, const QString &name) {
+    TB_TRACE_SCOPE("toolbar", "registerToolbar");
+    if (!toolbar::isLoaded(def)) {
+      auto am = PLUG_Services::getActionManager();
+      if (!am) {
+        TB_LOG_ERROR(Toolbar, "Could not get AC_Manager!");
+        return false;
+      }
+      // Before the toolbar is built, so its icons come from the atlas.
+      icons::installImageHook(am);
       QList<QString> ids;
-      am->loadToolbars(element, ids);
-      debug::out << "Registered toolbar with AC_Manager. IDs loaded: "
-                << ids.size() << std::endl;
-      for (const auto &id : ids) {
-        debug::out << "  - " << id.toStdString() << std::endl;
+      am->loadToolbars(def.toolbarsElement(), ids);
+      toolbar::markLoaded(def);
+      TB_LOG_DEBUG(Toolbar, "Registered toolbar with AC_Manager. IDs loaded: {}",
+                   ids.size());
+      if (log::enabled(log::Category::Toolbar, log::Level::Trace)) {
+        for (const auto &id : ids) {
+          TB_LOG_TRACE(Toolbar, "  - {}", id.toStdString());
+        }
       }
-    } else {
-      std::cerr << "Could not get AC_Manager!" << std::endl;
-      return false;
     }
     auto layToolbarInfo = getToolbarInfo();
-    QList<QString> btns;
-    for (int i = 0; i < docEl.childNodes().size(); i++) {
-      auto node = docEl.childNodes().at(i).toElement();
-      btns.append(node.attribute("id"));
-    }
     layToolbarInfo.setName(name);
-    layToolbarInfo.setButtonConfig(&btns);
-    layToolbarInfo.setButtonDefaultConfig(&btns);
+    layToolbarInfo.setButtonConfig(&def.buttonIds);
+    layToolbarInfo.setButtonDefaultConfig(&def.buttonIds);
     setToolbarInfo(layToolbarInfo);
     return true;
   }
 
   virtual T *createWidget() = 0;
+
+private:
+  QMetaObject::Connection m_parentConnection;
+  std::unique_ptr<QObject> m_viewContext;
+  std::size_t m_poolCost = 0;
+  std::string m_poolKey;
 };
\ No newline at end of file
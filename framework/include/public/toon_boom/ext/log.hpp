@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "./util.hpp"
+
+/**
+ * @brief Asynchronous framework logger.
+ *
+ * Each thread that logs gets its own single-producer/single-consumer ring of
+ * fixed-size records. Producers format straight into a ring slot with
+ * std::format_to_n and publish it with one release store; they never lock,
+ * allocate or touch the console or a file. A background thread drains every
+ * ring, formats timestamps and writes to a size-rotated log file (and the
+ * console when enabled).
+ *
+ * When a ring is full the record is dropped and counted rather than blocking
+ * the caller; the drop count is written to the log once there is room.
+ *
+ * Prefer the TB_LOG_* macros over calling writef() directly: levels below
+ * TB_EXT_FRAMEWORK_LOG_LEVEL compile to nothing, and for compiled-in levels
+ * the arguments are only evaluated once the category/level check passes.
+ *
+ * The macros go through writeFields(): the producer copies each argument into
+ * the record as a typed field (integer, floating point, bool, pointer or
+ * string) and keeps a pointer to the format literal. Text is only produced
+ * on the drain thread, so logging on the GUI thread never formats or
+ * allocates. Their format strings support plain `{}` placeholders only (and
+ * `{{`/`}}`); use writef() when you need format specs.
+ *
+ * @code
+ * TB_LOG_DEBUG(Layout, "raised {} in {} us", name.toStdString(), us);
+ * @endcode
+ */
+
+// 0 = Trace ... 4 = Error. Calls below this level are compiled out entirely.
+#if !defined(TB_EXT_FRAMEWORK_LOG_LEVEL)
+#if TB_EXT_FRAMEWORK_DEBUG
+#define TB_EXT_FRAMEWORK_LOG_LEVEL 0
+#else
+#define TB_EXT_FRAMEWORK_LOG_LEVEL 2
+#endif
+#endif
+
+namespace util::log {
+
+enum class Level : std::uint8_t { Trace, Debug, Info, Warn, Error };
+
+/// At most 8 categories: the runtime filter packs one byte of level bits per
+/// category into a single 64-bit word.
+enum class Category : std::uint8_t {
+  General,
+  Hooks,
+  Script,
+  Layout,
+  Toolbar,
+  Actions,
+  Extension,
+};
+
+constexpr bool compiledIn(Level level) {
+  return static_cast<int>(level) >= TB_EXT_FRAMEWORK_LOG_LEVEL;
+}
+
+namespace detail {
+constexpr std::uint64_t filterBit(Category category, Level level) {
+  return std::uint64_t{1} << (static_cast<unsigned>(category) * 8 +
+                              static_cast<unsigned>(level));
+}
+extern std::atomic<std::uint64_t> g_filter;
+} // namespace detail
+
+/// One relaxed load and a test against a constant; cheap enough to sit in
+/// front of every log call.
+inline bool enabled(Category category, Level level) {
+  return (detail::g_filter.load(std::memory_order_relaxed) &
+          detail::filterBit(category, level)) != 0;
+}
+
+/// Enables level and above for category at runtime. Levels that are not
+/// compiled in stay disabled.
+void setLevel(Category category, Level level);
+/// setLevel for every category.
+void setLevel(Level level);
+
+struct Config {
+  /// Empty means `%TEMP%/toon-boom-extension-framework/framework.log`.
+  std::filesystem::path path;
+  std::uintmax_t maxFileBytes = 8u << 20;
+  /// Rotated files kept next to the active one (`framework.log.1` ...).
+  unsigned maxFiles = 4;
+  /// Echo every record to stdout. Warn and above always go to stderr.
+  bool echoToConsole = TB_EXT_FRAMEWORK_DEBUG != 0;
+};
+
+struct Record {
+  static constexpr std::size_t kTextCapacity = 232;
+
+  std::chrono::system_clock::rep timestamp;
+  std::uint32_t threadId;
+  Level level;
+  Category category;
+  std::uint16_t length;
+  /// Null: text holds the finished message. Otherwise a format literal
+  /// whose `{}` placeholders take the fields encoded in text.
+  const char *format;
+  char text[kTextCapacity];
+};
+static_assert(sizeof(Record) == 256, "keep records a fixed 256 bytes");
+
+/// Applies to the next file the logger opens; the current file is reopened
+/// on the next drain.
+void configure(const Config &config);
+
+/// Copies text (truncated to Record::kTextCapacity) into the calling thread's
+/// ring.
+void write(Level level, std::string_view text);
+void write(Category category, Level level, std::string_view text);
+
+/// Synchronously drains every ring and flushes the log file.
+void flush();
+
+/// Records dropped because a ring was full, across all threads.
+std::uint64_t dropped();
+
+namespace detail {
+/// Returns a slot in the calling thread's ring stamped with level, category,
+/// time and thread id, or nullptr if the ring is full. Must be followed by
+/// publish().
+Record *acquire(Level level, Category category = Category::General);
+void publish();
+} // namespace detail
+
+/// Formats into the calling thread's ring without allocating. Output longer
+/// than Record::kTextCapacity is truncated.
+template <typename... Args>
+void writef(Category category, Level level, std::format_string<Args...> fmt,
+            Args &&...args) {
+  Record *record = detail::acquire(level, category);
+  if (!record) return;
+  auto result = std::format_to_n(record->text, Record::kTextCapacity, fmt,
+                                 std::forward<Args>(args)...);
+  record->length = static_cast<std::uint16_t>(std::min<std::ptrdiff_t>(
+      result.size, static_cast<std::ptrdiff_t>(Record::kTextCapacity)));
+  detail::publish();
+}
+
+template <typename... Args>
+void writef(Level level, std::format_string<Args...> fmt, Args &&...args) {
+  writef(Category::General, level, fmt, std::forward<Args>(args)...);
+}
+
+namespace detail {
+
+enum class FieldTag : std::uint8_t { Int, UInt, Double, Bool, Pointer, String };
+
+template <typename T>
+constexpr bool isStringField =
+    std::is_convertible_v<const T &, std::string_view>;
+
+template <typename T>
+constexpr bool isField = isStringField<T> || std::is_arithmetic_v<T> ||
+                         std::is_pointer_v<T> || std::is_enum_v<T>;
+
+/// Appends tagged fields to a record's text buffer. Strings are truncated to
+/// fit. Fields are decoded by position, so once one does not fit at all it
+/// and every field after it are left out.
+class FieldWriter {
+public:
+  FieldWriter(char *buffer, std::size_t capacity)
+      : m_buffer(buffer), m_capacity(capacity) {}
+
+  template <typename T> void put(const T &value) {
+    if constexpr (isStringField<T>) {
+      const std::string_view text(value);
+      if (!reserve(2)) return;
+      const auto n = (std::min)(text.size(), m_capacity - m_size - 2);
+      m_buffer[m_size++] = static_cast<char>(FieldTag::String);
+      m_buffer[m_size++] = static_cast<char>(static_cast<std::uint8_t>(n));
+      text.copy(m_buffer + m_size, n);
+      m_size += n;
+    } else if constexpr (std::is_same_v<T, bool>) {
+      scalar(FieldTag::Bool, static_cast<std::uint64_t>(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+      scalar(FieldTag::Double, static_cast<double>(value));
+    } else if constexpr (std::is_pointer_v<T>) {
+      scalar(FieldTag::Pointer, reinterpret_cast<std::uintptr_t>(value));
+    } else if constexpr (std::is_enum_v<T>) {
+      put(static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_signed_v<T>) {
+      scalar(FieldTag::Int, static_cast<std::int64_t>(value));
+    } else {
+      scalar(FieldTag::UInt, static_cast<std::uint64_t>(value));
+    }
+  }
+
+  std::size_t size() const { return m_size; }
+
+private:
+  template <typename V> void scalar(FieldTag tag, V value) {
+    static_assert(sizeof(V) == 8);
+    if (!reserve(1 + sizeof(V))) return;
+    m_buffer[m_size++] = static_cast<char>(tag);
+    std::memcpy(m_buffer + m_size, &value, sizeof(V));
+    m_size += sizeof(V);
+  }
+
+  bool reserve(std::size_t bytes) {
+    if (!m_full && m_size + bytes > m_capacity) m_full = true;
+    return !m_full;
+  }
+
+  char *m_buffer;
+  std::size_t m_capacity;
+  std::size_t m_size = 0;
+  bool m_full = false;
+};
+
+consteval std::size_t countPlaceholders(const char *text) {
+  std::size_t count = 0;
+  for (; *text; ++text) {
+    if ((text[0] == '{' && text[1] == '{') ||
+        (text[0] == '}' && text[1] == '}')) {
+      ++text;
+    } else if (text[0] == '{') {
+      if (text[1] != '}') throw "only {} placeholders are supported";
+      ++count;
+      ++text;
+    } else if (text[0] == '}') {
+      throw "unmatched } in log format";
+    }
+  }
+  return count;
+}
+
+} // namespace detail
+
+/// A format literal checked at compile time against the argument count.
+template <typename... Args> struct FieldFormat {
+  template <std::size_t N>
+  consteval FieldFormat(const char (&literal)[N]) : text(literal) {
+    if (detail::countPlaceholders(literal) != sizeof...(Args)) {
+      throw "placeholder count does not match the arguments";
+    }
+  }
+  const char *text;
+};
+
+/// Copies args into the calling thread's ring as typed fields; the drain
+/// thread substitutes them into fmt. fmt must be a string literal in a module
+/// that stays loaded until the record is drained.
+template <typename... Args>
+void writeFields(Category category, Level level,
+                 FieldFormat<std::type_identity_t<Args>...> fmt,
+                 const Args &...args) {
+  static_assert((detail::isField<Args> && ...),
+                "log fields must be integers, floats, bools, enums, pointers "
+                "or convertible to std::string_view");
+  Record *record = detail::acquire(level, category);
+  if (!record) return;
+  record->format = fmt.text;
+  detail::FieldWriter writer(record->text, Record::kTextCapacity);
+  (writer.put(args), ...);
+  record->length = static_cast<std::uint16_t>(writer.size());
+  detail::publish();
+}
+
+} // namespace util::log
+
+#define TB_LOG(level, category, ...)                                           \
+  do {                                                                         \
+    if constexpr (::util::log::compiledIn(level)) {                            \
+      if (::util::log::enabled(category, level)) [[unlikely]] {               \
+        ::util::log::writeFields(category, level, __VA_ARGS__);                \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+
+#define TB_LOG_TRACE(category, ...)                                            \
+  TB_LOG(::util::log::Level::Trace, ::util::log::Category::category, __VA_ARGS__)
+#define TB_LOG_DEBUG(category, ...)                                            \
+  TB_LOG(::util::log::Level::Debug, ::util::log::Category::category, __VA_ARGS__)
+#define TB_LOG_INFO(category, ...)                                             \
+  TB_LOG(::util::log::Level::Info, ::util::log::Category::category, __VA_ARGS__)
+#define TB_LOG_WARN(category, ...)                                             \
+  TB_LOG(::util::log::Level::Warn, ::util::log::Category::category, __VA_ARGS__)
+#define TB_LOG_ERROR(category, ...)                                            \
+  TB_LOG(::util::log::Level::Error, ::util::log::Category::category, __VA_ARGS__)
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief In-process metrics: counters, gauges and latency histograms.
+ *
+ * Metrics are created on first lookup by name and live for the rest of the
+ * process, so call sites look them up once and keep the reference:
+ *
+ * @code
+ * static auto &runs = util::metrics::counter("hooks.runs");
+ * static auto &latency = util::metrics::histogram("hooks.run_ns");
+ * util::metrics::ScopedTimer timer(latency);
+ * runs.add();
+ * @endcode
+ *
+ * Updates are relaxed atomics. Counters are split across cache-line-sized
+ * shards picked per thread, so threads bumping the same counter do not
+ * contend. Histograms bucket values log-linearly (8 linear sub-buckets per
+ * power of two, so any recorded value is reported within 12.5%).
+ *
+ * The whole registry can be read with snapshot(), is exposed to scripts as
+ * `frameworkMetrics.snapshot()`, and can be written to a JSON file
+ * periodically via configure() or the `TB_EXT_METRICS_FILE` environment
+ * variable.
+ */
+
+namespace util::metrics {
+
+class Counter {
+public:
+  static constexpr std::size_t kShards = 16;
+
+  void add(std::uint64_t n = 1) {
+    m_shards[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+  std::uint64_t value() const;
+
+private:
+  struct alignas(64) Shard {
+    std::atomic<std::uint64_t> value{0};
+  };
+  static std::size_t shardIndex();
+
+  Shard m_shards[kShards];
+};
+
+class Gauge {
+public:
+  void set(std::int64_t value) {
+    m_value.store(value, std::memory_order_relaxed);
+  }
+  void add(std::int64_t delta) {
+    m_value.fetch_add(delta, std::memory_order_relaxed);
+  }
+  std::int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<std::int64_t> m_value{0};
+};
+
+struct HistogramSnapshot {
+  std::uint64_t count = 0;
+  std::uint64_t sum = 0;
+  std::uint64_t max = 0;
+  /// Upper bound of the bucket holding each quantile.
+  std::uint64_t p50 = 0;
+  std::uint64_t p90 = 0;
+  std::uint64_t p99 = 0;
+};
+
+class Histogram {
+public:
+  static constexpr unsigned kSubBucketBits = 3;
+  static constexpr unsigned kSubBuckets = 1u << kSubBucketBits;
+  static constexpr std::size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  static constexpr std::size_t bucketFor(std::uint64_t value) {
+    if (value < kSubBuckets) return static_cast<std::size_t>(value);
+    const unsigned shift = std::bit_width(value) - 1 - kSubBucketBits;
+    return (shift + 1) * kSubBuckets +
+           static_cast<std::size_t>((value >> shift) & (kSubBuckets - 1));
+  }
+
+  /// Largest value that lands in bucket.
+  static constexpr std::uint64_t bucketUpperBound(std::size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    const unsigned shift = static_cast<unsigned>(bucket / kSubBuckets) - 1;
+    const std::uint64_t sub = bucket % kSubBuckets;
+    return ((kSubBuckets + sub) << shift) + ((std::uint64_t{1} << shift) - 1);
+  }
+
+  void record(std::uint64_t value) {
+    m_buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    auto max = m_max.load(std::memory_order_relaxed);
+    while (value > max &&
+           !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  HistogramSnapshot snapshot() const;
+
+private:
+  std::array<std::atomic<std::uint64_t>, kBuckets> m_buckets{};
+  std::atomic<std::uint64_t> m_sum{0};
+  std::atomic<std::uint64_t> m_max{0};
+};
+
+static_assert(Histogram::bucketFor(7) == 7);
+static_assert(Histogram::bucketFor(8) == 8 && Histogram::bucketFor(15) == 15);
+static_assert(Histogram::bucketFor(16) == 16 && Histogram::bucketFor(17) == 16);
+static_assert(Histogram::bucketUpperBound(16) == 17);
+static_assert(Histogram::bucketFor(~std::uint64_t{0}) == Histogram::kBuckets - 1);
+
+/// Returns the metric registered under name, creating it on first use. The
+/// reference stays valid for the life of the process. Takes a lock; look up
+/// once and keep the reference on hot paths.
+Counter &counter(std::string_view name);
+Gauge &gauge(std::string_view name);
+Histogram &histogram(std::string_view name);
+
+/// Records the lifetime of the scope into a histogram, in nanoseconds.
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Histogram &histogram)
+      : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    m_histogram.record(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_start)
+            .count()));
+  }
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Histogram &m_histogram;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+/// Every metric, sorted by name within each kind.
+struct Snapshot {
+  std::vector<std::pair<std::string, std::uint64_t>> counters;
+  std::vector<std::pair<std::string, std::int64_t>> gauges;
+  std::vector<std::pair<std::string, HistogramSnapshot>> histograms;
+};
+
+Snapshot snapshot();
+std::string toJson(const Snapshot &snapshot);
+
+struct Config {
+  /// Empty disables the periodic dump.
+  std::filesystem::path path;
+  std::chrono::milliseconds interval{std::chrono::seconds(30)};
+};
+
+/// Starts (or retargets) the periodic dump. The file is rewritten in place on
+/// each interval.
+void configure(const Config &config);
+
+} // namespace util::metrics
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+class AC_ActionInfo;
+class AC_ResponderBase;
+class QWidget;
+enum class AC_Result : int;
+
+/**
+ * @brief Interned responder identities and an identity -> responder index.
+ *
+ * An Atom stands for one responder identity string for the life of the
+ * process: interning the same text always yields the same Atom, so
+ * comparing atoms compares two integers and hashing them reads a
+ * precomputed hash. Intern once, typically into a static, and use the atom
+ * from then on.
+ *
+ * Responders registered through registerResponder() here rather than
+ * directly with AC_Manager are also indexed by their atom, so
+ * responder(atom) and trigger(atom, ...) find them with an array lookup
+ * instead of AC_Manager's string search.
+ *
+ * @code
+ * static const auto kCounter = util::responders::intern("counter");
+ * util::responders::trigger(kCounter, "onActionIncrementCounter()");
+ * @endcode
+ *
+ * intern() is thread-safe; the index is GUI thread only, like AC_Manager.
+ */
+
+namespace util::responders {
+
+class Atom {
+public:
+  constexpr Atom() = default;
+
+  bool valid() const { return m_id != 0; }
+  std::uint32_t id() const { return m_id; }
+  std::uint64_t hash() const { return m_hash; }
+  /// The interned identity; an empty string for the invalid atom.
+  const QString &name() const;
+
+  friend bool operator==(Atom a, Atom b) { return a.m_id == b.m_id; }
+
+private:
+  friend Atom intern(const QString &identity);
+  constexpr Atom(std::uint32_t id, std::uint64_t hash) : m_id(id), m_hash(hash) {}
+
+  std::uint32_t m_id = 0;
+  std::uint64_t m_hash = 0;
+};
+
+Atom intern(const QString &identity);
+Atom intern(std::string_view identity);
+
+/// AC_Manager::registerResponder() on the responder's manager, plus
+/// indexing under responder.responderAtom().
+bool registerResponder(AC_ResponderBase &responder, QWidget *widget);
+void unregisterResponder(AC_ResponderBase &responder);
+
+/// The most recently registered responder with this identity, or nullptr.
+AC_ResponderBase *responder(Atom identity);
+
+/// Every registered responder with this identity, oldest first.
+const std::vector<AC_ResponderBase *> &responders(Atom identity);
+
+/// AC_ResponderBase::performAction() on the newest responder with this
+/// identity, or on all of them with forEachResponder. NotHandled if none is
+/// registered.
+AC_Result trigger(Atom identity, std::string_view slot,
+                  AC_ActionInfo *info = nullptr, bool forEachResponder = false);
+
+} // namespace util::responders
+
+template <> struct std::hash<util::responders::Atom> {
+  std::size_t operator()(util::responders::Atom atom) const noexcept {
+    return static_cast<std::size_t>(atom.hash());
+  }
+};
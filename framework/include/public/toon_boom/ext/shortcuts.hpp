@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class AC_Manager;
+class QKeyEvent;
+
+/**
+ * @brief Matches key events against a fixed set of AC_Manager shortcuts.
+ *
+ * AC_Manager::isShortcut() resolves the shortcut by name and compares key
+ * sequences on every call, so a view checking dozens of shortcuts per key
+ * press does dozens of string lookups. An Accelerator asks AC_Manager for
+ * each shortcut's QKeySequence once and compiles them into a trie of
+ * (modifiers | key) chords; matching a key press is then one hash probe,
+ * whatever the number of shortcuts.
+ *
+ * The trie is rebuilt on the next match() after shortcuts are reloaded.
+ * When the framework's hooks are active, AC_Manager::loadShortcuts() is
+ * hooked to do this automatically; otherwise call invalidate() after
+ * changing bindings.
+ *
+ * @code
+ * m_shortcuts = std::make_unique<util::shortcuts::Accelerator>(
+ *     manager, std::vector<QString>{"MyView_Zoom", "MyView_Reset"});
+ *
+ * void MyView::keyPressEvent(QKeyEvent *event) {
+ *   auto match = m_shortcuts->match(event);
+ *   if (match.kind == util::shortcuts::Match::Full) run(match.shortcut);
+ *   if (match.kind != util::shortcuts::Match::None) event->accept();
+ * }
+ * @endcode
+ *
+ * GUI thread only.
+ */
+
+namespace util::shortcuts {
+
+struct Match {
+  enum Kind {
+    None,    ///< not a prefix of any shortcut; state was reset
+    Partial, ///< first chords of a multi-chord shortcut; keep feeding keys
+    Full,    ///< a whole shortcut; state was reset
+  };
+  Kind kind = None;
+  /// Index into the accelerator's shortcut list, for Full matches.
+  int shortcut = -1;
+};
+
+class Accelerator {
+public:
+  /// shortcuts are AC_Manager shortcut names, as in the shortcuts XML.
+  Accelerator(AC_Manager *manager, std::vector<QString> shortcuts);
+
+  /// Advances by one key press. Presses of bare modifier keys are ignored.
+  Match match(const QKeyEvent *event);
+
+  /// Abandons a partially typed multi-chord shortcut.
+  void reset() { m_node = 0; }
+
+  const QString &name(int shortcut) const { return m_names[shortcut]; }
+
+private:
+  void rebuild();
+
+  AC_Manager *m_manager;
+  std::vector<QString> m_names;
+  // Edge (node << 32 | chord) -> child node. Node 0 is the root.
+  std::unordered_map<std::uint64_t, std::uint32_t> m_edges;
+  // Shortcut index ending at each node, or -1.
+  std::vector<int> m_terminal;
+  std::uint32_t m_node = 0;
+  std::uint64_t m_generation = 0;
+};
+
+/// Makes every Accelerator rebuild on its next match().
+void invalidate();
+
+/// Bumped by invalidate() and by hooked AC_Manager::loadShortcuts() calls.
+std::uint64_t generation();
+
+} // namespace util::shortcuts
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+/**
+ * @brief The framework's shared work-stealing thread pool.
+ *
+ * Every worker owns a Chase-Lev deque: it pushes and pops its own tasks at
+ * one end without locking while idle workers steal from the other end.
+ * Tasks submitted from threads outside the pool go through a shared
+ * injection queue. Framework code and extensions should use this pool rather
+ * than starting their own std::threads inside Harmony.
+ *
+ * The pool starts on first use with configure()'s worker count (by default
+ * one less than the number of hardware threads). Workers are detached and
+ * never joined, for the same loader-lock reasons as the log drain thread.
+ *
+ * Never block on pool work from DllMain: threads cannot start while the
+ * loader lock is held. parallelFor() is the exception, since its caller
+ * runs chunks itself and never waits on a task that has not started.
+ *
+ * @code
+ * util::tasks::TaskGroup group;
+ * for (auto &file : files) group.run([&file]() { index(file); });
+ * group.wait();
+ * util::tasks::postToGui([]() { refreshView(); });
+ * @endcode
+ */
+
+namespace util::tasks {
+
+struct Config {
+  /// 0 picks hardware_concurrency() - 1, at least 1.
+  unsigned workers = 0;
+};
+
+/// Applies only before the pool has started. Returns false if it already
+/// has.
+bool configure(const Config &config);
+
+unsigned workerCount();
+
+/// True on a pool worker thread.
+bool onWorkerThread();
+
+/// Fire-and-forget. Exceptions escaping fn are logged and swallowed.
+void post(std::function<void()> fn);
+
+/// Queues fn on the Qt GUI thread's event loop. Returns false if there is no
+/// QCoreApplication yet.
+bool postToGui(std::function<void()> fn);
+
+/**
+ * @brief A set of tasks that can be waited on or cancelled together.
+ *
+ * Cancelling skips tasks that have not started yet; tasks already running
+ * can poll cancelled() to stop early. The destructor waits.
+ */
+class TaskGroup {
+public:
+  TaskGroup() = default;
+  ~TaskGroup() { wait(); }
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  void run(std::function<void()> fn);
+  void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+  /// Returns once every task passed to run() has finished or been skipped.
+  /// On a worker thread this runs other pool tasks while it waits.
+  void wait();
+
+private:
+  friend struct TaskRunner;
+  void finishOne();
+
+  std::atomic<std::size_t> m_pending{0};
+  std::atomic<bool> m_cancelled{false};
+  std::mutex m_mutex;
+  std::condition_variable m_done;
+};
+
+/// Calls fn(chunkBegin, chunkEnd) over [begin, end) in chunks of at most
+/// grain, on the pool and on the calling thread, and returns when every chunk
+/// has run. fn must be safe to call concurrently.
+void parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                 const std::function<void(std::size_t, std::size_t)> &fn);
+
+} // namespace util::tasks
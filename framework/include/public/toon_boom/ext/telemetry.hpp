@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "./telemetry_ring.hpp"
+
+/**
+ * @brief Live log and metrics feed from the framework to the injector.
+ *
+ * When the process starts with `TB_EXT_TELEMETRY` set (the injector sets it
+ * in `-v` mode) the framework creates the shared-memory ring described in
+ * telemetry_ring.hpp under mappingName(pid). The log drain thread then
+ * publishes every log record into it, and a metrics snapshot is published
+ * once a second. Records are still echoed to stdout and stderr unless the
+ * variable is `console`, which the injector sets when it renders into the
+ * console the process writes to. Without the variable, or if the mapping
+ * cannot be created, nothing changes.
+ */
+
+namespace util::telemetry {
+
+/// True once the ring exists. Stays true for the life of the process.
+bool attached();
+
+/// True when attached and the injector renders records into this process's
+/// console, so echoing them there would print everything twice.
+bool rendersConsole();
+
+/// Copies one record into the ring and wakes a sleeping reader. Safe to call
+/// from any thread; returns false if not attached or the ring is full.
+bool publish(RecordKind kind, std::uint8_t level, std::string_view source,
+             std::uint32_t threadId, std::int64_t timestampNs,
+             std::string_view payload);
+
+} // namespace util::telemetry
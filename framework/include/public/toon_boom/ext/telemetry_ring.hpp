@@ -0,0 +1,265 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Wire format of the framework's shared-memory telemetry channel.
+ *
+ * A single-producer, single-consumer byte ring laid out in a block of shared
+ * memory: a RingHeader, then `capacity` bytes of records. The framework
+ * writes; the injector reads the records in place, without copying them out.
+ * Nothing here touches the OS, so the same code runs on both ends of a
+ * Windows file mapping and on POSIX shared memory.
+ *
+ * Every record starts on an 8-byte boundary with a RecordHeader followed by
+ * its payload. A record never wraps: when it does not fit before the end of
+ * the buffer the writer fills the rest with a padding record (or leaves it
+ * alone if even a header would not fit) and starts again at offset 0. A full
+ * ring drops the new record and counts it in RingHeader::dropped.
+ *
+ * @code
+ * // producer
+ * util::telemetry::RingWriter writer(memory);
+ * writer.write(header, "hello");
+ * if (writer.readerWaiting()) signalEvent();
+ *
+ * // consumer
+ * util::telemetry::RingReader reader(memory);
+ * while (auto record = reader.peek()) {
+ *   render(*record);
+ *   reader.consume();
+ * }
+ * @endcode
+ */
+
+namespace util::telemetry {
+
+constexpr std::uint32_t kMagic = 0x4D4C4554; // "TELM"
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kDefaultCapacity = std::size_t{1} << 20;
+constexpr std::size_t kRecordAlignment = 8;
+
+enum class RecordKind : std::uint16_t {
+  Padding = 0,
+  Log = 1,     ///< payload is the message text
+  Metrics = 2, ///< payload is util::metrics::toJson() output
+};
+
+struct RingHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t capacity; ///< record bytes after the header; a power of two
+  std::uint32_t headerSize;
+  alignas(64) std::atomic<std::uint64_t> head; ///< bytes written, ever
+  alignas(64) std::atomic<std::uint64_t> tail; ///< bytes consumed, ever
+  alignas(64) std::atomic<std::uint64_t> dropped;
+  /// Set by a reader about to sleep, so the writer knows to signal it.
+  std::atomic<std::uint32_t> readerWaiting;
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "the ring is shared between processes");
+
+struct RecordHeader {
+  std::uint32_t size; ///< payload bytes
+  RecordKind kind;
+  std::uint8_t level; ///< util::log::Level for Log records
+  std::uint8_t reserved;
+  std::uint32_t threadId;
+  std::uint32_t reserved2;
+  std::int64_t timestamp; ///< nanoseconds since the Unix epoch
+  char source[8];         ///< e.g. the log category; not null-terminated
+};
+static_assert(sizeof(RecordHeader) == 32);
+
+struct RecordView {
+  const RecordHeader *header;
+  std::string_view payload;
+
+  std::string_view source() const {
+    return {header->source, strnlen(header->source, sizeof(header->source))};
+  }
+};
+
+constexpr std::size_t kDataOffset =
+    (sizeof(RingHeader) + 63) / 64 * 64;
+
+/// Bytes of shared memory needed for a ring of `capacity` record bytes.
+constexpr std::size_t mappingSize(std::size_t capacity) {
+  return kDataOffset + capacity;
+}
+
+constexpr std::size_t recordSpan(std::size_t payload) {
+  return (sizeof(RecordHeader) + payload + kRecordAlignment - 1) /
+         kRecordAlignment * kRecordAlignment;
+}
+
+/// Names of the Windows file mapping and wake event for a process.
+inline std::string mappingName(std::uint32_t pid) {
+  return "Local\\toon-boom-extension-framework-telemetry-" +
+         std::to_string(pid);
+}
+
+inline std::string eventName(std::uint32_t pid) {
+  return mappingName(pid) + "-event";
+}
+
+class RingWriter {
+public:
+  /// Formats a fresh ring in memory, which must be mappingSize(capacity)
+  /// bytes and suitably aligned. capacity must be a power of two.
+  static RingHeader *create(void *memory, std::uint32_t capacity) {
+    auto *header = new (memory) RingHeader{};
+    header->capacity = capacity;
+    header->headerSize = static_cast<std::uint32_t>(kDataOffset);
+    header->version = kVersion;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_relaxed);
+    header->readerWaiting.store(0, std::memory_order_relaxed);
+    // Readers check the magic last, after everything else is in place.
+    std::atomic_ref<std::uint32_t>(header->magic)
+        .store(kMagic, std::memory_order_release);
+    return header;
+  }
+
+  explicit RingWriter(void *memory)
+      : m_header(static_cast<RingHeader *>(memory)),
+        m_data(static_cast<char *>(memory) + kDataOffset) {}
+
+  /// Copies one record in. Returns false, and counts a drop, if the ring is
+  /// too full.
+  bool write(const RecordHeader &fields, std::string_view payload) {
+    const std::uint64_t capacity = m_header->capacity;
+    const std::uint64_t span = recordSpan(payload.size());
+    if (span > capacity) return drop();
+
+    auto head = m_header->head.load(std::memory_order_relaxed);
+    const auto tail = m_header->tail.load(std::memory_order_acquire);
+    const std::uint64_t offset = head & (capacity - 1);
+    const std::uint64_t contiguous = capacity - offset;
+    const std::uint64_t needed = span > contiguous ? contiguous + span : span;
+    if (capacity - (head - tail) < needed) return drop();
+
+    if (span > contiguous) {
+      if (contiguous >= sizeof(RecordHeader)) {
+        RecordHeader padding{};
+        padding.kind = RecordKind::Padding;
+        padding.size =
+            static_cast<std::uint32_t>(contiguous - sizeof(RecordHeader));
+        std::memcpy(m_data + offset, &padding, sizeof(padding));
+      }
+      head += contiguous;
+    }
+
+    char *at = m_data + (head & (capacity - 1));
+    RecordHeader header = fields;
+    header.size = static_cast<std::uint32_t>(payload.size());
+    std::memcpy(at, &header, sizeof(header));
+    std::memcpy(at + sizeof(header), payload.data(), payload.size());
+    m_header->head.store(head + span, std::memory_order_release);
+    return true;
+  }
+
+  /// Whether a reader is asleep and needs its wake event set. Call after
+  /// write().
+  bool readerWaiting() const {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return m_header->readerWaiting.load(std::memory_order_relaxed) != 0;
+  }
+
+private:
+  bool drop() {
+    m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  RingHeader *m_header;
+  char *m_data;
+};
+
+class RingReader {
+public:
+  explicit RingReader(const void *memory)
+      : m_header(static_cast<RingHeader *>(const_cast<void *>(memory))),
+        m_data(static_cast<const char *>(memory) + kDataOffset) {}
+
+  /// False if memory does not hold a ring this reader understands, or if a
+  /// corrupt record was found.
+  bool valid() const {
+    if (m_corrupt) return false;
+    const auto magic = std::atomic_ref<std::uint32_t>(m_header->magic)
+                           .load(std::memory_order_acquire);
+    const auto capacity = m_header->capacity;
+    return magic == kMagic && m_header->version == kVersion &&
+           m_header->headerSize == kDataOffset && capacity >= 64 &&
+           (capacity & (capacity - 1)) == 0;
+  }
+
+  /// The oldest unread record, pointing into the ring. Stays valid until
+  /// consume().
+  std::optional<RecordView> peek() {
+    if (!valid()) return std::nullopt;
+    const std::uint64_t capacity = m_header->capacity;
+    for (;;) {
+      auto tail = m_header->tail.load(std::memory_order_relaxed);
+      const auto head = m_header->head.load(std::memory_order_acquire);
+      if (tail == head) return std::nullopt;
+      const std::uint64_t offset = tail & (capacity - 1);
+      const std::uint64_t contiguous = capacity - offset;
+      if (contiguous < sizeof(RecordHeader)) {
+        m_header->tail.store(tail + contiguous, std::memory_order_release);
+        continue;
+      }
+      const auto *header =
+          reinterpret_cast<const RecordHeader *>(m_data + offset);
+      if (recordSpan(header->size) > contiguous ||
+          recordSpan(header->size) > head - tail) {
+        m_corrupt = true;
+        return std::nullopt;
+      }
+      if (header->kind == RecordKind::Padding) {
+        m_header->tail.store(tail + contiguous, std::memory_order_release);
+        continue;
+      }
+      m_span = recordSpan(header->size);
+      return RecordView{header, {m_data + offset + sizeof(RecordHeader),
+                                 header->size}};
+    }
+  }
+
+  /// Releases the record returned by the last peek() to the writer.
+  void consume() {
+    m_header->tail.fetch_add(m_span, std::memory_order_release);
+    m_span = 0;
+  }
+
+  std::uint64_t dropped() const {
+    return m_header->dropped.load(std::memory_order_relaxed);
+  }
+
+  /// Bracket a sleep on the wake event: prepare, re-check peek(), wait only
+  /// if it is still empty, then finish.
+  void prepareWait() {
+    m_header->readerWaiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void finishWait() {
+    m_header->readerWaiting.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  RingHeader *m_header;
+  const char *m_data;
+  std::uint64_t m_span = 0;
+  bool m_corrupt = false;
+};
+
+} // namespace util::telemetry
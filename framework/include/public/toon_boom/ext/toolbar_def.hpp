@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtXml/QDomDocument>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Toolbar XML compiled once into flat, immutable definitions.
+ *
+ * compile() parses a `<toolbars>` document (or a bare `<toolbar>`) and keeps
+ * the result in a process-wide cache keyed by a hash of the XML text, so
+ * views that register the same toolbar every time they are created pay for
+ * the parse once. load() does the same for XML precompiled at build time,
+ * skipping the parse entirely. Registration then only walks the precomputed arrays; the
+ * DOM is kept for AC_Manager::loadToolbars(), which only accepts XML.
+ *
+ * Definitions are shared and never change after compile(). GUI thread only,
+ * like the QDomDocument they hold.
+ *
+ * @code
+ * static const auto kToolbar = util::toolbar::compile(R"XML(<toolbars>...)XML");
+ * registerToolbar(*kToolbar);
+ * @endcode
+ */
+
+namespace util::toolbar {
+
+struct Item {
+  QString id;
+  QString slot;
+  QString icon;
+  QString responder;
+  QString text;
+};
+
+struct Definition {
+  QString id;
+  QString text;
+  bool customizable = false;
+  bool visible = true;
+  std::vector<Item> items;
+  /// Item ids in order, ready for TULayoutView's button config.
+  QList<QString> buttonIds;
+  /// The `<toolbars>` document the definition was compiled from.
+  QDomDocument document;
+  std::uint64_t hash = 0;
+
+  /// The `<toolbars>` element to hand to AC_Manager::loadToolbars().
+  QDomElement toolbarsElement() const { return document.documentElement(); }
+  /// The `<toolbar>` element, e.g. for TULayoutView::toolbar().
+  QDomElement toolbarElement() const {
+    return document.documentElement().firstChildElement("toolbar");
+  }
+};
+
+/// Compiles the first `<toolbar>` in xml, or returns the cached definition
+/// for identical xml. nullptr, with error set if given, when the XML does
+/// not parse or has no toolbar.
+std::shared_ptr<const Definition> compile(const QString &xml,
+                                          QString *error = nullptr);
+
+/// Compiles an already parsed `<toolbars>` or `<toolbar>` element. Cached
+/// by the element's serialized text.
+std::shared_ptr<const Definition> compile(const QDomElement &element,
+                                          QString *error = nullptr);
+
+/// Loads a toolbar embedded at build time by toonboom_embed_xml() (see
+/// xml_blob.hpp). No XML is parsed; the DOM is built straight from the
+/// blob. Cached by the blob's address, which is static.
+std::shared_ptr<const Definition> load(std::span<const std::uint8_t> blob,
+                                       QString *error = nullptr);
+
+/// The document of any embedded blob, e.g. a `<menus>` file for
+/// AC_Manager::loadMenus(). Null when the blob is malformed. Not cached.
+QDomDocument loadDocument(std::span<const std::uint8_t> blob,
+                          QString *error = nullptr);
+
+/// Whether def has already been passed to AC_Manager::loadToolbars() in this
+/// process. markLoaded() records that it has.
+bool isLoaded(const Definition &def);
+void markLoaded(const Definition &def);
+
+/// Drops every cached definition. Definitions still referenced stay valid.
+void clearCache();
+
+} // namespace util::toolbar
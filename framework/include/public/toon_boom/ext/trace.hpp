@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+/**
+ * @brief Scoped-span tracing in the Chrome trace-event format.
+ *
+ * TB_TRACE_SCOPE records a complete ("X") event covering the enclosing scope
+ * into a buffer owned by the calling thread. Recording never locks: a thread
+ * appends to its own chunk and publishes it with one release store. The
+ * buffers can be written out as JSON at any time and are written
+ * automatically when the framework is unloaded, so the result loads directly
+ * in Perfetto or chrome://tracing.
+ *
+ * Tracing is off unless the `TB_EXT_TRACE_FILE` environment variable names an
+ * output file when the framework is loaded, or start() is called. While off,
+ * a span costs one relaxed load.
+ *
+ * @code
+ * void loadEverything() {
+ *   TB_TRACE_SCOPE("startup", "loadEverything");
+ *   ...
+ * }
+ * @endcode
+ */
+
+// Set to 0 to compile every TB_TRACE_SCOPE out.
+#if !defined(TB_EXT_FRAMEWORK_TRACE)
+#define TB_EXT_FRAMEWORK_TRACE 1
+#endif
+
+namespace util::trace {
+
+struct Event {
+  static constexpr std::size_t kDetailCapacity = 32;
+
+  /// Both must have static storage duration; only the pointers are kept.
+  const char *name;
+  const char *category;
+  std::int64_t startNs;
+  std::int64_t durationNs;
+  char detail[kDetailCapacity];
+};
+static_assert(sizeof(Event) == 64, "keep events a fixed 64 bytes");
+
+namespace detail {
+extern std::atomic<bool> g_enabled;
+
+inline std::int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void record(const Event &event);
+} // namespace detail
+
+inline bool enabled() {
+  return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+/// Starts recording. If path is not empty it replaces the file written on
+/// unload.
+void start(const std::filesystem::path &path = {});
+/// Stops recording. Events already recorded are kept.
+void stop();
+
+/// Writes every event recorded so far as Chrome trace JSON. Safe to call
+/// while other threads are still recording.
+bool writeJson(const std::filesystem::path &path);
+
+/// Events discarded because a thread hit its buffer limit.
+std::uint64_t dropped();
+
+class Scope {
+public:
+  Scope(const char *category, const char *name) {
+    if (enabled()) {
+      m_event.name = name;
+      m_event.category = category;
+      m_event.detail[0] = '\0';
+      m_event.startNs = detail::now();
+    }
+  }
+  ~Scope() {
+    if (m_event.name) {
+      m_event.durationNs = detail::now() - m_event.startNs;
+      detail::record(m_event);
+    }
+  }
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+  /// False when tracing was off as the scope opened; check before building an
+  /// expensive detail string.
+  bool active() const { return m_event.name != nullptr; }
+
+  /// Attached to the event as `args.detail`, truncated to
+  /// Event::kDetailCapacity - 1 bytes.
+  void setDetail(std::string_view text) {
+    if (!active()) return;
+    const auto n = text.size() < Event::kDetailCapacity
+                       ? text.size()
+                       : Event::kDetailCapacity - 1;
+    text.copy(m_event.detail, n);
+    m_event.detail[n] = '\0';
+  }
+
+private:
+  Event m_event{};
+};
+
+} // namespace util::trace
+
+#define TB_TRACE_CONCAT_(a, b) a##b
+#define TB_TRACE_CONCAT(a, b) TB_TRACE_CONCAT_(a, b)
+
+#if TB_EXT_FRAMEWORK_TRACE
+#define TB_TRACE_SCOPE(category, name)                                         \
+  ::util::trace::Scope TB_TRACE_CONCAT(tb_trace_scope_, __LINE__) {            \
+    category, name                                                             \
+  }
+#else
+#define TB_TRACE_SCOPE(category, name) static_cast<void>(0)
+#endif
@@ -1,21 +1,85 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <format>
 #include <iostream>
+#include <span>
 #include <streambuf>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 #if !defined(TB_EXT_FRAMEWORK_DEBUG)
 #define TB_EXT_FRAMEWORK_DEBUG 0
 #endif
 
+namespace util {
+constexpr std::uint64_t kFnv1aBasis = 0xcbf29ce484222325ull;
+
+/**
+ * @brief 64-bit FNV-1a over a run of units: bytes, UTF-16 code units or whole
+ * words, one multiply per unit. Pass the previous result as seed to hash data
+ * in pieces. Only for in-process and cache keys; hashing the same data in
+ * different units gives different values.
+ */
+template <typename Unit, std::size_t Extent>
+constexpr std::uint64_t fnv1a(std::span<Unit, Extent> units,
+                              std::uint64_t seed = kFnv1aBasis) {
+  using Value = std::remove_cv_t<Unit>;
+  static_assert(std::is_integral_v<Value>);
+  std::uint64_t hash = seed;
+  for (Value unit : units) {
+    hash ^= static_cast<std::make_unsigned_t<Value>>(unit);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+constexpr std::uint64_t fnv1a(std::string_view text,
+                              std::uint64_t seed = kFnv1aBasis) {
+  return fnv1a(std::span<const char>(text.data(), text.size()), seed);
+}
+} // namespace util
+
 namespace util::debug {
 struct NullBuffer : std::streambuf {
   int overflow(int c) { return c; }
 };
 
+/**
+ * @brief An address formatted as `0x` plus at least 10 uppercase hex digits,
+ * held inline so formatting never allocates.
+ */
+struct HexAddress {
+  static constexpr std::size_t kCapacity = 2 + 16;
+
+  char text[kCapacity];
+  std::uint8_t size;
+
+  std::string_view view() const { return {text, size}; }
+  operator std::string_view() const { return view(); }
+};
+
+inline HexAddress toHex(const void *addr) {
+  HexAddress hex;
+  auto result = std::format_to_n(hex.text, HexAddress::kCapacity, "0x{:010X}",
+                                 reinterpret_cast<std::uintptr_t>(addr));
+  hex.size = static_cast<std::uint8_t>(result.size);
+  return hex;
+}
+
+/// Prefer toHex(); these allocate a std::string per call.
 std::string addrToHex(void *addr);
 
 std::string constAddrToHex(const void *addr);
 
 extern std::ostream &out;
-} // namespace util::debug
\ No newline at end of file
+} // namespace util::debug
+
+template <>
+struct std::formatter<util::debug::HexAddress> : std::formatter<std::string_view> {
+  auto format(const util::debug::HexAddress &hex, std::format_context &ctx) const {
+    return std::formatter<std::string_view>::format(hex.view(), ctx);
+  }
+};
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "./metrics.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class AC_Manager;
+
+/**
+ * @brief Cached action validation for extension responders.
+ *
+ * Harmony calls every responder's `on...Validate(AC_ActionInfo*)` slots each
+ * time a toolbar runs validateContent(), which can be many times a frame.
+ * AC_ResponderBase::validateCached() keeps each action's result until the
+ * responder calls invalidateActions(), and scheduleRevalidation() folds any
+ * number of invalidations into one AC_Manager::updateToolbars() per
+ * event-loop iteration.
+ *
+ * @code
+ * void MyWidget::onActionClearValidate(AC_ActionInfo *info) {
+ *   validateCached(info, "clear", [this](auto &state) {
+ *     state.enabled = !m_items.empty();
+ *   });
+ * }
+ * void MyWidget::setItems(Items items) {
+ *   m_items = std::move(items);
+ *   invalidateActions();
+ * }
+ * @endcode
+ */
+
+namespace util::actions {
+
+struct ActionState {
+  bool enabled = true;
+  /// Left alone on the action when not set.
+  std::optional<bool> visible;
+};
+
+/// One responder's validated states, keyed by a name of its choosing. GUI
+/// thread only.
+class ValidationCache {
+public:
+  /// The cached state for key, running compute(ActionState &) if there is
+  /// none.
+  template <typename F> ActionState get(std::string_view key, F &&compute) {
+    static auto &hits = metrics::counter("actions.validate_cache_hits");
+    static auto &misses = metrics::counter("actions.validate_cache_misses");
+    // A responder has a handful of actions; a flat scan beats hashing.
+    for (const auto &entry : m_entries) {
+      if (entry.key == key) {
+        hits.add();
+        return entry.state;
+      }
+    }
+    misses.add();
+    ActionState state;
+    compute(state);
+    m_entries.push_back({std::string(key), state});
+    return state;
+  }
+
+  void clear() { m_entries.clear(); }
+
+private:
+  struct Entry {
+    std::string key;
+    ActionState state;
+  };
+  std::vector<Entry> m_entries;
+};
+
+/// Has manager revalidate its toolbars once control returns to the event
+/// loop. Requests made before then share that one pass. GUI thread only.
+void scheduleRevalidation(AC_Manager *manager);
+
+} // namespace util::actions
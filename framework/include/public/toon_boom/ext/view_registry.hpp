@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../toon_boom_layout.hpp"
+
+#include <QtCore/QPoint>
+#include <QtCore/QSize>
+#include <QtCore/QString>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace util::layout {
+
+/// Index of a registered view type. Cheap to copy and compare; the default
+/// handle is invalid.
+struct ViewHandle {
+  std::uint32_t index = 0;
+
+  bool valid() const { return index != 0; }
+  friend bool operator==(ViewHandle, ViewHandle) = default;
+};
+
+/// Arguments for TULayoutManager::addArea() and raiseArea().
+struct ViewOptions {
+  bool docked = true;
+  QSize minSize = QSize(500, 400);
+  bool useMinSize = true;
+  QPoint position = QPoint(100, 100);
+  /// Name passed to raiseArea(); empty uses the display name.
+  QString raiseName;
+};
+
+/**
+ * @brief Extension view types, created on first use.
+ *
+ * add() only records the factory, so registering any number of views at
+ * startup costs a few allocations. The first raise() of a view runs its
+ * factory, adds it to TULayoutManager and records how long that took, in
+ * the `layout.view_create_ns` histogram and the view's own
+ * `layout.view_create_ns.<id>`. Later raise() calls only raise it.
+ *
+ * @code
+ * auto &views = util::layout::ViewRegistry::instance();
+ * static const auto kCounter = views.add(
+ *     "CounterView", "Counter View", []() { return new CounterView(); });
+ * views.raise(kCounter);
+ * @endcode
+ *
+ * GUI thread only.
+ */
+class ViewRegistry {
+public:
+  static ViewRegistry &instance();
+
+  /// Registers a view type under id, which must be unique. Re-adding an id
+  /// returns the existing handle and keeps the first factory.
+  ViewHandle add(std::string_view id, const QString &displayName,
+                 std::function<TULayoutView *()> factory,
+                 const ViewOptions &options = {});
+
+  /// Invalid handle if id was never added.
+  ViewHandle find(std::string_view id) const;
+
+  /// Creates and adds the view on first call, then raises it. nullptr if
+  /// the handle is invalid or the layout manager refused the view; a
+  /// refused view is not created again.
+  TULayoutView *raise(ViewHandle handle, TULayoutFrame *frame = nullptr);
+
+  /// The view's instance, or nullptr until its first raise().
+  TULayoutView *view(ViewHandle handle) const;
+
+  template <typename T> T *viewAs(ViewHandle handle) const {
+    return dynamic_cast<T *>(view(handle));
+  }
+
+  /// Zero until the view has been created.
+  std::chrono::nanoseconds creationTime(ViewHandle handle) const;
+
+  std::size_t size() const { return m_entries.size(); }
+
+private:
+  struct Entry {
+    std::string id;
+    QString displayName;
+    std::function<TULayoutView *()> factory;
+    ViewOptions options;
+    TULayoutView *view = nullptr;
+    // addArea() refused the view.
+    bool failed = false;
+    std::chrono::nanoseconds creationTime{0};
+  };
+
+  struct IdHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view id) const {
+      return std::hash<std::string_view>{}(id);
+    }
+  };
+
+  ViewRegistry() = default;
+  const Entry *entry(ViewHandle handle) const;
+  bool create(Entry &entry);
+
+  // A deque so each id's c_str() stays put for addArea().
+  std::deque<Entry> m_entries;
+  std::unordered_map<std::string, ViewHandle, IdHash, std::equal_to<>> m_byId;
+};
+
+} // namespace util::layout
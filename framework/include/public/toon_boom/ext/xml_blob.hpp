@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Binary form of toolbar and menu XML, produced at build time.
+ *
+ * toonboom_embed_xml() in the framework's CMakeLists runs toonboom_xmlc over
+ * an XML file, which validates it and writes a header holding the encoded
+ * document as a byte array. util::toolbar::load() and loadDocument() turn
+ * that back into a Definition or QDomDocument without running an XML
+ * parser. Nothing here depends on Qt so the tool can share it.
+ *
+ * Layout, all integers little-endian u32:
+ *
+ *   magic, version, stringCount, nodeCount, attributeCount
+ *   stringCount x (byteLength, UTF-8 bytes)
+ *   nodeCount x (tag, attributeCount, childCount), in preorder
+ *   attributeCount x (name, value), in node order
+ *
+ * Tags, names and values are indices into the string table, which holds each
+ * distinct string once. Only elements and attributes are kept.
+ */
+
+namespace util::xml_blob {
+
+constexpr std::uint32_t kMagic = 0x31584254; // "TBX1"
+constexpr std::uint32_t kVersion = 1;
+
+struct Node {
+  std::string tag;
+  std::vector<std::pair<std::string, std::string>> attributes;
+  std::vector<Node> children;
+};
+
+struct NodeRecord {
+  std::uint32_t tag;
+  std::uint32_t attributeCount;
+  std::uint32_t childCount;
+  std::uint32_t firstAttribute; ///< index into Decoded::attributes
+};
+
+/// Views into the encoded bytes, which must outlive it.
+struct Decoded {
+  std::vector<std::string_view> strings;
+  std::vector<NodeRecord> nodes;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> attributes;
+};
+
+namespace detail {
+
+inline void put(std::vector<std::uint8_t> &out, std::uint32_t value) {
+  for (int i = 0; i < 4; i++) out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+}
+
+struct Interner {
+  std::vector<std::string> strings;
+  std::vector<std::pair<std::string, std::uint32_t>> index; // sorted
+
+  std::uint32_t intern(const std::string &text) {
+    auto it = std::lower_bound(
+        index.begin(), index.end(), text,
+        [](const auto &entry, const std::string &key) { return entry.first < key; });
+    if (it != index.end() && it->first == text) return it->second;
+    const auto id = static_cast<std::uint32_t>(strings.size());
+    strings.push_back(text);
+    index.insert(it, {text, id});
+    return id;
+  }
+};
+
+inline void flatten(const Node &node, Interner &strings,
+                    std::vector<std::uint32_t> &nodes,
+                    std::vector<std::uint32_t> &attributes) {
+  nodes.push_back(strings.intern(node.tag));
+  nodes.push_back(static_cast<std::uint32_t>(node.attributes.size()));
+  nodes.push_back(static_cast<std::uint32_t>(node.children.size()));
+  for (const auto &[name, value] : node.attributes) {
+    attributes.push_back(strings.intern(name));
+    attributes.push_back(strings.intern(value));
+  }
+  for (const auto &child : node.children) flatten(child, strings, nodes, attributes);
+}
+
+} // namespace detail
+
+inline std::vector<std::uint8_t> encode(const Node &root) {
+  detail::Interner strings;
+  std::vector<std::uint32_t> nodes;
+  std::vector<std::uint32_t> attributes;
+  detail::flatten(root, strings, nodes, attributes);
+
+  std::vector<std::uint8_t> out;
+  detail::put(out, kMagic);
+  detail::put(out, kVersion);
+  detail::put(out, static_cast<std::uint32_t>(strings.strings.size()));
+  detail::put(out, static_cast<std::uint32_t>(nodes.size() / 3));
+  detail::put(out, static_cast<std::uint32_t>(attributes.size() / 2));
+  for (const auto &text : strings.strings) {
+    detail::put(out, static_cast<std::uint32_t>(text.size()));
+    out.insert(out.end(), text.begin(), text.end());
+  }
+  for (auto value : nodes) detail::put(out, value);
+  for (auto value : attributes) detail::put(out, value);
+  return out;
+}
+
+/// False if data is not a well-formed blob of this version.
+inline bool decode(std::span<const std::uint8_t> data, Decoded &result) {
+  std::size_t at = 0;
+  auto get = [&](std::uint32_t &value) {
+    if (data.size() - at < 4) return false;
+    value = 0;
+    for (int i = 0; i < 4; i++) value |= std::uint32_t{data[at + i]} << (8 * i);
+    at += 4;
+    return true;
+  };
+
+  std::uint32_t magic, version, stringCount, nodeCount, attributeCount;
+  if (!get(magic) || !get(version) || !get(stringCount) || !get(nodeCount) ||
+      !get(attributeCount) || magic != kMagic || version != kVersion) {
+    return false;
+  }
+  // Every entry takes at least four bytes; reject absurd counts before
+  // reserving for them.
+  if (stringCount > data.size() / 4 || nodeCount > data.size() / 12 ||
+      attributeCount > data.size() / 8 || nodeCount == 0) {
+    return false;
+  }
+
+  result.strings.clear();
+  result.strings.reserve(stringCount);
+  for (std::uint32_t i = 0; i < stringCount; i++) {
+    std::uint32_t length;
+    if (!get(length) || data.size() - at < length) return false;
+    result.strings.emplace_back(reinterpret_cast<const char *>(data.data() + at), length);
+    at += length;
+  }
+
+  result.nodes.clear();
+  result.nodes.reserve(nodeCount);
+  std::uint64_t attributesUsed = 0;
+  // Children still expected by each open ancestor, to check the preorder
+  // describes exactly one tree.
+  std::vector<std::uint32_t> pending;
+  for (std::uint32_t i = 0; i < nodeCount; i++) {
+    NodeRecord node{};
+    if (!get(node.tag) || !get(node.attributeCount) || !get(node.childCount) ||
+        node.tag >= stringCount) {
+      return false;
+    }
+    while (!pending.empty() && pending.back() == 0) pending.pop_back();
+    if (i > 0) {
+      if (pending.empty()) return false;
+      pending.back()--;
+    }
+    pending.push_back(node.childCount);
+    node.firstAttribute = static_cast<std::uint32_t>(attributesUsed);
+    attributesUsed += node.attributeCount;
+    result.nodes.push_back(node);
+  }
+  while (!pending.empty() && pending.back() == 0) pending.pop_back();
+  if (!pending.empty() || attributesUsed != attributeCount) return false;
+
+  result.attributes.clear();
+  result.attributes.reserve(attributeCount);
+  for (std::uint32_t i = 0; i < attributeCount; i++) {
+    std::uint32_t name, value;
+    if (!get(name) || !get(value) || name >= stringCount || value >= stringCount) {
+      return false;
+    }
+    result.attributes.emplace_back(name, value);
+  }
+  return at == data.size();
+}
+
+} // namespace util::xml_blob
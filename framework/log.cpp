@@ -0,0 +1,447 @@
+#include "include/public/toon_boom/ext/log.hpp"
+#include "include/public/toon_boom/ext/telemetry.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <windows.h>
+
+namespace util::log {
+namespace {
+
+constexpr std::size_t kRingCapacity = 512; // power of two
+constexpr auto kIdleWait = std::chrono::milliseconds(25);
+constexpr unsigned kCategoryCount = 7;
+
+constexpr const char *kCategoryNames[kCategoryCount] = {
+    "general", "hooks", "script", "layout", "toolbar", "actions", "ext"};
+
+// Level bits for `level` and everything above it, limited to what is
+// compiled in, for one category's byte of the filter word.
+constexpr std::uint64_t levelMask(Level level) {
+  std::uint64_t mask = 0;
+  for (int l = static_cast<int>(level); l <= static_cast<int>(Level::Error);
+       ++l) {
+    if (compiledIn(static_cast<Level>(l))) mask |= std::uint64_t{1} << l;
+  }
+  return mask;
+}
+
+constexpr std::uint64_t filterFor(Level level) {
+  std::uint64_t filter = 0;
+  for (unsigned c = 0; c < kCategoryCount; ++c) {
+    filter |= levelMask(level) << (c * 8);
+  }
+  return filter;
+}
+
+// Substitutes the fields writeFields() encoded into record.text for the `{}`
+// placeholders of record.format. Fields that were dropped because the record
+// was full print as `{?}`.
+void appendFields(std::string &out, const Record &record) {
+  using detail::FieldTag;
+  std::size_t pos = 0;
+  auto scalar = [&](auto &value) {
+    std::memcpy(&value, record.text + pos, sizeof(value));
+    pos += sizeof(value);
+  };
+  auto appendField = [&]() {
+    if (pos >= record.length) {
+      out += "{?}";
+      return;
+    }
+    const auto tag = static_cast<FieldTag>(record.text[pos++]);
+    switch (tag) {
+    case FieldTag::Int: {
+      std::int64_t value;
+      scalar(value);
+      std::format_to(std::back_inserter(out), "{}", value);
+      break;
+    }
+    case FieldTag::UInt: {
+      std::uint64_t value;
+      scalar(value);
+      std::format_to(std::back_inserter(out), "{}", value);
+      break;
+    }
+    case FieldTag::Double: {
+      double value;
+      scalar(value);
+      std::format_to(std::back_inserter(out), "{}", value);
+      break;
+    }
+    case FieldTag::Bool: {
+      std::uint64_t value;
+      scalar(value);
+      out += value ? "true" : "false";
+      break;
+    }
+    case FieldTag::Pointer: {
+      std::uint64_t value;
+      scalar(value);
+      std::format_to(std::back_inserter(out), "0x{:010X}", value);
+      break;
+    }
+    case FieldTag::String: {
+      const auto n = static_cast<std::uint8_t>(record.text[pos++]);
+      out.append(record.text + pos, n);
+      pos += n;
+      break;
+    }
+    }
+  };
+
+  for (const char *f = record.format; *f; ++f) {
+    if ((f[0] == '{' && f[1] == '{') || (f[0] == '}' && f[1] == '}')) {
+      out.push_back(*f++);
+    } else if (f[0] == '{' && f[1] == '}') {
+      appendField();
+      ++f;
+    } else {
+      out.push_back(*f);
+    }
+  }
+}
+
+struct ThreadRing {
+  alignas(64) std::atomic<std::uint64_t> head{0};
+  std::uint64_t cachedTail = 0; // producer-only copy of tail
+  alignas(64) std::atomic<std::uint64_t> tail{0};
+  alignas(64) std::atomic<std::uint64_t> dropped{0};
+  std::atomic<bool> orphaned{false};
+  std::uint32_t threadId = 0;
+  Record slots[kRingCapacity];
+};
+
+class Logger {
+public:
+  // Leaked on purpose: the drain thread is never joined because doing so
+  // from DllMain would deadlock on the loader lock.
+  static Logger &instance() {
+    static Logger *logger = new Logger();
+    return *logger;
+  }
+
+  static bool exists() { return s_exists.load(std::memory_order_acquire); }
+
+  ThreadRing *registerThread() {
+    auto ring = std::make_unique<ThreadRing>();
+    ring->threadId = static_cast<std::uint32_t>(GetCurrentThreadId());
+    auto *raw = ring.get();
+    std::lock_guard lock(m_ringsMutex);
+    m_rings.push_back(std::move(ring));
+    return raw;
+  }
+
+  void configure(const Config &config) {
+    std::lock_guard lock(m_configMutex);
+    m_pendingConfig = config;
+    m_configDirty = true;
+  }
+
+  // Returns false if the drain lock could not be taken without blocking.
+  bool flush(bool blocking) {
+    std::unique_lock lock(m_drainMutex, std::defer_lock);
+    if (blocking) {
+      lock.lock();
+    } else if (!lock.try_lock()) {
+      return false;
+    }
+    drainOnce();
+    return true;
+  }
+
+  std::uint64_t dropped() {
+    std::lock_guard lock(m_ringsMutex);
+    std::uint64_t total = m_retiredDropped;
+    for (const auto &ring : m_rings) {
+      total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+private:
+  Logger() {
+    std::thread([this]() { run(); }).detach();
+    s_exists.store(true, std::memory_order_release);
+  }
+
+  void run() {
+    for (;;) {
+      bool drained = false;
+      {
+        std::lock_guard lock(m_drainMutex);
+        drained = drainOnce();
+      }
+      if (!drained) std::this_thread::sleep_for(kIdleWait);
+    }
+  }
+
+  // Requires m_drainMutex.
+  bool drainOnce() {
+    applyConfig();
+
+    std::vector<ThreadRing *> rings;
+    {
+      std::lock_guard lock(m_ringsMutex);
+      rings.reserve(m_rings.size());
+      for (const auto &ring : m_rings) rings.push_back(ring.get());
+    }
+
+    bool drained = false;
+    for (auto *ring : rings) {
+      auto tail = ring->tail.load(std::memory_order_relaxed);
+      const auto head = ring->head.load(std::memory_order_acquire);
+      for (; tail != head; ++tail) {
+        emit(ring->slots[tail & (kRingCapacity - 1)]);
+        drained = true;
+      }
+      ring->tail.store(tail, std::memory_order_release);
+    }
+
+    reapOrphans();
+
+    const auto totalDropped = dropped();
+    if (totalDropped > m_reportedDropped) {
+      writeLine(std::format("[log] {} records dropped (ring full)\n",
+                            totalDropped - m_reportedDropped),
+                Level::Warn);
+      m_reportedDropped = totalDropped;
+      drained = true;
+    }
+
+    if (drained && m_file.is_open()) m_file.flush();
+    return drained;
+  }
+
+  // Frees rings whose thread has exited and that have been fully drained.
+  void reapOrphans() {
+    std::lock_guard lock(m_ringsMutex);
+    std::erase_if(m_rings, [this](const std::unique_ptr<ThreadRing> &ring) {
+      if (!ring->orphaned.load(std::memory_order_acquire)) return false;
+      if (ring->tail.load(std::memory_order_relaxed) !=
+          ring->head.load(std::memory_order_acquire)) {
+        return false;
+      }
+      m_retiredDropped += ring->dropped.load(std::memory_order_relaxed);
+      return true;
+    });
+  }
+
+  void emit(const Record &record) {
+    static constexpr char kLevelChars[] = {'T', 'D', 'I', 'W', 'E'};
+    const std::chrono::system_clock::time_point tp{
+        std::chrono::system_clock::duration{record.timestamp}};
+    m_line.clear();
+    const auto category = static_cast<unsigned>(record.category);
+    std::format_to(std::back_inserter(m_line),
+                   "{:%Y-%m-%d %H:%M:%S}Z {} {:>5} [{}] ",
+                   std::chrono::floor<std::chrono::microseconds>(tp),
+                   kLevelChars[static_cast<int>(record.level)],
+                   record.threadId,
+                   category < kCategoryCount ? kCategoryNames[category] : "?");
+    const auto messageStart = m_line.size();
+    if (record.format) {
+      appendFields(m_line, record);
+    } else {
+      m_line.append(record.text, record.length);
+    }
+    if (telemetry::attached()) {
+      telemetry::publish(
+          telemetry::RecordKind::Log, static_cast<std::uint8_t>(record.level),
+          category < kCategoryCount ? kCategoryNames[category] : "?",
+          record.threadId,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              tp.time_since_epoch())
+              .count(),
+          std::string_view(m_line).substr(messageStart));
+    }
+    m_line.push_back('\n');
+    writeLine(m_line, record.level);
+  }
+
+  void writeLine(std::string_view line, Level level) {
+    // The injector renders every record from the telemetry ring; when it
+    // does so into our console, echoing too would print everything twice.
+    // Echo still goes to a redirected log file.
+    if (!telemetry::rendersConsole()) {
+      if (level >= Level::Warn) {
+        std::fwrite(line.data(), 1, line.size(), stderr);
+      } else if (m_config.echoToConsole) {
+        std::fwrite(line.data(), 1, line.size(), stdout);
+      }
+    }
+    if (!m_file.is_open()) return;
+    if (m_fileBytes + line.size() > m_config.maxFileBytes) rotate();
+    m_file.write(line.data(), static_cast<std::streamsize>(line.size()));
+    m_fileBytes += line.size();
+  }
+
+  void applyConfig() {
+    {
+      std::lock_guard lock(m_configMutex);
+      if (!m_configDirty) return;
+      m_config = m_pendingConfig;
+      m_configDirty = false;
+    }
+    if (m_config.path.empty()) {
+      std::error_code ec;
+      auto dir = std::filesystem::temp_directory_path(ec);
+      if (!ec) {
+        m_config.path =
+            dir / "toon-boom-extension-framework" / "framework.log";
+      }
+    }
+    openFile(std::ios::app);
+  }
+
+  void openFile(std::ios::openmode mode) {
+    if (m_file.is_open()) m_file.close();
+    if (m_config.path.empty()) return;
+    std::error_code ec;
+    std::filesystem::create_directories(m_config.path.parent_path(), ec);
+    m_file.open(m_config.path, std::ios::binary | std::ios::out | mode);
+    if (!m_file.is_open()) {
+      std::fprintf(stderr, "[log] could not open %s\n",
+                   m_config.path.string().c_str());
+      return;
+    }
+    m_fileBytes = std::filesystem::file_size(m_config.path, ec);
+    if (ec) m_fileBytes = 0;
+  }
+
+  void rotate() {
+    m_file.close();
+    std::error_code ec;
+    auto numbered = [this](unsigned i) {
+      auto p = m_config.path;
+      p += "." + std::to_string(i);
+      return p;
+    };
+    if (m_config.maxFiles > 0) {
+      std::filesystem::remove(numbered(m_config.maxFiles), ec);
+      for (unsigned i = m_config.maxFiles; i > 1; --i) {
+        std::filesystem::rename(numbered(i - 1), numbered(i), ec);
+      }
+      std::filesystem::rename(m_config.path, numbered(1), ec);
+    }
+    openFile(std::ios::trunc);
+    m_fileBytes = 0;
+  }
+
+  static inline std::atomic<bool> s_exists{false};
+
+  std::mutex m_ringsMutex;
+  std::vector<std::unique_ptr<ThreadRing>> m_rings;
+  std::uint64_t m_retiredDropped = 0;
+
+  std::mutex m_configMutex;
+  Config m_pendingConfig;
+  bool m_configDirty = true;
+
+  // Everything below is only touched with m_drainMutex held.
+  std::mutex m_drainMutex;
+  Config m_config;
+  std::ofstream m_file;
+  std::uintmax_t m_fileBytes = 0;
+  std::string m_line;
+  std::uint64_t m_reportedDropped = 0;
+};
+
+struct RingHandle {
+  ThreadRing *ring = nullptr;
+  ~RingHandle() {
+    if (ring) ring->orphaned.store(true, std::memory_order_release);
+  }
+};
+
+thread_local RingHandle t_ring;
+
+// Best-effort drain when the DLL is unloaded or the process exits. The drain
+// thread may already have been killed mid-drain, so never block on it.
+struct FlushOnUnload {
+  ~FlushOnUnload() {
+    if (Logger::exists()) Logger::instance().flush(false);
+  }
+} flush_on_unload;
+
+} // namespace
+
+void configure(const Config &config) { Logger::instance().configure(config); }
+
+void setLevel(Category category, Level level) {
+  const auto shift = static_cast<unsigned>(category) * 8;
+  auto filter = detail::g_filter.load(std::memory_order_relaxed);
+  std::uint64_t next;
+  do {
+    next = (filter & ~(std::uint64_t{0xFF} << shift)) |
+           (levelMask(level) << shift);
+  } while (!detail::g_filter.compare_exchange_weak(
+      filter, next, std::memory_order_relaxed));
+}
+
+void setLevel(Level level) {
+  detail::g_filter.store(filterFor(level), std::memory_order_relaxed);
+}
+
+void write(Level level, std::string_view text) {
+  write(Category::General, level, text);
+}
+
+void write(Category category, Level level, std::string_view text) {
+  Record *record = detail::acquire(level, category);
+  if (!record) return;
+  const auto n = std::min(text.size(), Record::kTextCapacity);
+  std::memcpy(record->text, text.data(), n);
+  record->length = static_cast<std::uint16_t>(n);
+  detail::publish();
+}
+
+void flush() { Logger::instance().flush(true); }
+
+std::uint64_t dropped() { return Logger::instance().dropped(); }
+
+namespace detail {
+
+std::atomic<std::uint64_t> g_filter{
+    filterFor(TB_EXT_FRAMEWORK_DEBUG ? Level::Debug : Level::Info)};
+
+Record *acquire(Level level, Category category) {
+  ThreadRing *ring = t_ring.ring;
+  if (!ring) ring = t_ring.ring = Logger::instance().registerThread();
+
+  const auto head = ring->head.load(std::memory_order_relaxed);
+  if (head - ring->cachedTail >= kRingCapacity) {
+    ring->cachedTail = ring->tail.load(std::memory_order_acquire);
+    if (head - ring->cachedTail >= kRingCapacity) {
+      ring->dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+  }
+  Record &record = ring->slots[head & (kRingCapacity - 1)];
+  record.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+  record.threadId = ring->threadId;
+  record.level = level;
+  record.category = category;
+  record.length = 0;
+  record.format = nullptr;
+  return &record;
+}
+
+void publish() {
+  ThreadRing *ring = t_ring.ring;
+  ring->head.store(ring->head.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+}
+
+} // namespace detail
+
+} // namespace util::log
@@ -0,0 +1,228 @@
+#include "include/public/toon_boom/ext/metrics.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <format>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <windows.h>
+
+namespace util::metrics {
+namespace {
+
+// Lookups take the lock; updates never do. Nodes are never erased, so the
+// references handed out stay valid.
+class Registry {
+public:
+  // Leaked on purpose: call sites hold references in function-local statics
+  // that may be used while the DLL is being torn down.
+  static Registry &instance() {
+    static Registry *registry = new Registry();
+    return *registry;
+  }
+
+  Counter &counter(std::string_view name) { return get(m_counters, name); }
+  Gauge &gauge(std::string_view name) { return get(m_gauges, name); }
+  Histogram &histogram(std::string_view name) { return get(m_histograms, name); }
+
+  Snapshot snapshot() {
+    Snapshot result;
+    std::lock_guard lock(m_mutex);
+    result.counters.reserve(m_counters.size());
+    for (const auto &[name, metric] : m_counters) {
+      result.counters.emplace_back(name, metric->value());
+    }
+    result.gauges.reserve(m_gauges.size());
+    for (const auto &[name, metric] : m_gauges) {
+      result.gauges.emplace_back(name, metric->value());
+    }
+    result.histograms.reserve(m_histograms.size());
+    for (const auto &[name, metric] : m_histograms) {
+      result.histograms.emplace_back(name, metric->snapshot());
+    }
+    return result;
+  }
+
+private:
+  template <typename T>
+  using MetricMap = std::map<std::string, std::unique_ptr<T>, std::less<>>;
+
+  Registry() = default;
+
+  template <typename T> T &get(MetricMap<T> &metrics, std::string_view name) {
+    std::lock_guard lock(m_mutex);
+    auto it = metrics.find(name);
+    if (it == metrics.end()) {
+      it = metrics.emplace(std::string(name), std::make_unique<T>()).first;
+    }
+    return *it->second;
+  }
+
+  std::mutex m_mutex;
+  MetricMap<Counter> m_counters;
+  MetricMap<Gauge> m_gauges;
+  MetricMap<Histogram> m_histograms;
+};
+
+class PeriodicDump {
+public:
+  static PeriodicDump &instance() {
+    static PeriodicDump *dump = new PeriodicDump();
+    return *dump;
+  }
+
+  void configure(const Config &config) {
+    {
+      std::lock_guard lock(m_mutex);
+      m_config = config;
+      if (!m_started && !m_config.path.empty()) {
+        m_started = true;
+        // Detached and leaked like the log drain thread; joining from
+        // DllMain would deadlock on the loader lock.
+        std::thread([this]() { run(); }).detach();
+      }
+    }
+    m_wake.notify_one();
+  }
+
+private:
+  PeriodicDump() = default;
+
+  void run() {
+    std::unique_lock lock(m_mutex);
+    for (;;) {
+      const auto interval =
+          std::max(m_config.interval, std::chrono::milliseconds(100));
+      m_wake.wait_for(lock, interval);
+      const auto path = m_config.path;
+      if (path.empty()) continue;
+      lock.unlock();
+      write(path);
+      lock.lock();
+    }
+  }
+
+  static void write(const std::filesystem::path &path) {
+    const auto json = toJson(snapshot());
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto tmp = path;
+    tmp += ".tmp";
+    {
+      std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+      if (!file.is_open()) return;
+      file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    }
+    // Readers never see a half-written file.
+    std::filesystem::rename(tmp, path, ec);
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  Config m_config;
+  bool m_started = false;
+};
+
+struct MetricsFromEnvironment {
+  MetricsFromEnvironment() {
+    char value[MAX_PATH] = {};
+    const DWORD n = GetEnvironmentVariableA("TB_EXT_METRICS_FILE", value, MAX_PATH);
+    if (n == 0 || n >= MAX_PATH) return;
+    Config config;
+    config.path = value;
+    configure(config);
+  }
+} metrics_from_environment;
+
+} // namespace
+
+std::size_t Counter::shardIndex() {
+  static std::atomic<std::size_t> next{0};
+  thread_local const std::size_t index =
+      next.fetch_add(1, std::memory_order_relaxed) % kShards;
+  return index;
+}
+
+std::uint64_t Counter::value() const {
+  std::uint64_t total = 0;
+  for (const auto &shard : m_shards) {
+    total += shard.value.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+  HistogramSnapshot result;
+  std::array<std::uint64_t, kBuckets> counts;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+    result.count += counts[i];
+  }
+  result.sum = m_sum.load(std::memory_order_relaxed);
+  result.max = m_max.load(std::memory_order_relaxed);
+  if (result.count == 0) return result;
+
+  // Ranks are 1-based: the p-quantile is the ceil(p * count)-th value.
+  auto rank = [&](unsigned percent) {
+    return std::max<std::uint64_t>(1, (result.count * percent + 99) / 100);
+  };
+  const std::pair<std::uint64_t, std::uint64_t *> targets[] = {
+      {rank(50), &result.p50}, {rank(90), &result.p90}, {rank(99), &result.p99}};
+  std::uint64_t seen = 0;
+  std::size_t next = 0;
+  for (std::size_t i = 0; i < kBuckets && next < std::size(targets); ++i) {
+    seen += counts[i];
+    while (next < std::size(targets) && seen >= targets[next].first) {
+      *targets[next].second = std::min(bucketUpperBound(i), result.max);
+      ++next;
+    }
+  }
+  return result;
+}
+
+Counter &counter(std::string_view name) {
+  return Registry::instance().counter(name);
+}
+
+Gauge &gauge(std::string_view name) { return Registry::instance().gauge(name); }
+
+Histogram &histogram(std::string_view name) {
+  return Registry::instance().histogram(name);
+}
+
+Snapshot snapshot() { return Registry::instance().snapshot(); }
+
+std::string toJson(const Snapshot &snapshot) {
+  // Metric names are code identifiers like "hooks.run_ns"; no escaping needed.
+  std::string out = "{\"counters\":{";
+  const char *sep = "";
+  for (const auto &[name, value] : snapshot.counters) {
+    std::format_to(std::back_inserter(out), "{}\"{}\":{}", sep, name, value);
+    sep = ",";
+  }
+  out += "},\"gauges\":{";
+  sep = "";
+  for (const auto &[name, value] : snapshot.gauges) {
+    std::format_to(std::back_inserter(out), "{}\"{}\":{}", sep, name, value);
+    sep = ",";
+  }
+  out += "},\"histograms\":{";
+  sep = "";
+  for (const auto &[name, h] : snapshot.histograms) {
+    std::format_to(std::back_inserter(out),
+                   "{}\"{}\":{{\"count\":{},\"sum\":{},\"max\":{},\"p50\":{},"
+                   "\"p90\":{},\"p99\":{}}}",
+                   sep, name, h.count, h.sum, h.max, h.p50, h.p90, h.p99);
+    sep = ",";
+  }
+  out += "}}\n";
+  return out;
+}
+
+void configure(const Config &config) { PeriodicDump::instance().configure(config); }
+
+} // namespace util::metrics
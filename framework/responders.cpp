@@ -0,0 +1,126 @@
+#include "include/public/toon_boom/ext/responders.hpp"
+#include "include/public/toon_boom/ac_manager.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+#include "include/public/toon_boom/ext/util.hpp"
+
+#include <QtCore/QHash>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+namespace util::responders {
+namespace {
+
+struct AtomTable {
+  std::mutex mutex;
+  // Index 0 is the invalid atom. A deque so names never move.
+  std::deque<QString> names{QString()};
+  QHash<QString, std::uint32_t> ids;
+};
+
+// Leaked, like the framework's other singletons: atoms may be interned from
+// static initializers and used until the process exits.
+AtomTable &atoms() {
+  static auto *table = new AtomTable();
+  return *table;
+}
+
+// Indexed by Atom::id(); GUI thread only.
+std::vector<std::vector<AC_ResponderBase *>> &index() {
+  static auto *byAtom = new std::vector<std::vector<AC_ResponderBase *>>();
+  return *byAtom;
+}
+
+std::uint64_t hashOf(const QString &text) {
+  return util::fnv1a(
+      std::span(reinterpret_cast<const char16_t *>(text.utf16()),
+                static_cast<std::size_t>(text.size())));
+}
+
+const std::vector<AC_ResponderBase *> &empty() {
+  static const std::vector<AC_ResponderBase *> none;
+  return none;
+}
+
+} // namespace
+
+const QString &Atom::name() const {
+  auto &table = atoms();
+  std::lock_guard lock(table.mutex);
+  return table.names[m_id];
+}
+
+Atom intern(const QString &identity) {
+  const auto hash = hashOf(identity);
+  auto &table = atoms();
+  std::lock_guard lock(table.mutex);
+  auto it = table.ids.constFind(identity);
+  if (it != table.ids.constEnd()) return Atom(it.value(), hash);
+  const auto id = static_cast<std::uint32_t>(table.names.size());
+  table.names.push_back(identity);
+  table.ids.insert(identity, id);
+  return Atom(id, hash);
+}
+
+Atom intern(std::string_view identity) {
+  return intern(QString::fromUtf8(identity.data(),
+                                  static_cast<qsizetype>(identity.size())));
+}
+
+bool registerResponder(AC_ResponderBase &responder, QWidget *widget) {
+  auto *manager = responder.actionManager();
+  if (!manager) {
+    TB_LOG_ERROR(Actions, "Responder {} has no AC_Manager",
+                 responder.responderIdentity().toStdString());
+    return false;
+  }
+  if (!manager->registerResponder(&responder, widget)) return false;
+  const auto id = responder.responderAtom().id();
+  auto &byAtom = index();
+  if (byAtom.size() <= id) byAtom.resize(id + 1);
+  auto &list = byAtom[id];
+  if (std::find(list.begin(), list.end(), &responder) == list.end()) {
+    list.push_back(&responder);
+  }
+  return true;
+}
+
+void unregisterResponder(AC_ResponderBase &responder) {
+  if (auto *manager = responder.actionManager()) {
+    manager->unregisterResponder(&responder);
+  }
+  const auto id = responder.responderAtom().id();
+  auto &byAtom = index();
+  if (id >= byAtom.size()) return;
+  auto &list = byAtom[id];
+  list.erase(std::remove(list.begin(), list.end(), &responder), list.end());
+}
+
+const std::vector<AC_ResponderBase *> &responders(Atom identity) {
+  auto &byAtom = index();
+  return identity.id() < byAtom.size() ? byAtom[identity.id()] : empty();
+}
+
+AC_ResponderBase *responder(Atom identity) {
+  const auto &list = responders(identity);
+  return list.empty() ? nullptr : list.back();
+}
+
+AC_Result trigger(Atom identity, std::string_view slot, AC_ActionInfo *info,
+                  bool forEachResponder) {
+  const auto &list = responders(identity);
+  if (list.empty()) return AC_Result::NotHandled;
+  if (!forEachResponder) return list.back()->performAction(slot, info);
+  // A slot may unregister responders, so re-check the bound every step
+  // rather than iterate over a copy.
+  auto result = AC_Result::NotHandled;
+  for (std::size_t i = list.size(); i-- > 0;) {
+    if (i >= list.size()) continue;
+    if (list[i]->performAction(slot, info) == AC_Result::Handled) {
+      result = AC_Result::Handled;
+    }
+  }
+  return result;
+}
+
+} // namespace util::responders
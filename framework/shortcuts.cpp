@@ -0,0 +1,136 @@
+#include "include/public/toon_boom/ext/shortcuts.hpp"
+#include "include/internal/vtable_hook.hpp"
+#include "include/public/toon_boom/ac_manager.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+#include "include/public/toon_boom/ext/metrics.hpp"
+
+#include <QtGui/QKeyEvent>
+
+namespace util::shortcuts {
+namespace {
+
+// Starts at 1 so a fresh Accelerator (generation 0) always builds.
+std::atomic<std::uint64_t> g_generation{1};
+
+constexpr int kLoadShortcutsElementSlot = 38;
+constexpr int kLoadShortcutsPathSlot = 39;
+
+using LoadShortcutsElement_t = void (*)(AC_Manager *, const QDomElement &);
+using LoadShortcutsPath_t = void (*)(AC_Manager *, const QString &);
+LoadShortcutsElement_t loadShortcutsElementOriginal = nullptr;
+LoadShortcutsPath_t loadShortcutsPathOriginal = nullptr;
+
+void loadShortcutsElementHook(AC_Manager *self, const QDomElement &element) {
+  loadShortcutsElementOriginal(self, element);
+  invalidate();
+}
+
+void loadShortcutsPathHook(AC_Manager *self, const QString &path) {
+  loadShortcutsPathOriginal(self, path);
+  invalidate();
+}
+
+// The implementations are shared by every manager, so hooking through the
+// first one seen covers them all. Without MinHook callers fall back to
+// invalidate().
+void hookLoadShortcuts(AC_Manager *manager) {
+  static const bool hooked = [manager]() {
+    using toon_boom_module::hooks::hook_virtual;
+    hook_virtual(manager, kLoadShortcutsElementSlot, &loadShortcutsElementHook,
+                 &loadShortcutsElementOriginal,
+                 "AC_Manager::loadShortcuts(element)");
+    hook_virtual(manager, kLoadShortcutsPathSlot, &loadShortcutsPathHook,
+                 &loadShortcutsPathOriginal, "AC_Manager::loadShortcuts(path)");
+    return true;
+  }();
+  (void)hooked;
+}
+
+bool isModifierKey(int key) {
+  return key == Qt::Key_Shift || key == Qt::Key_Control ||
+         key == Qt::Key_Alt || key == Qt::Key_Meta || key == Qt::Key_AltGr ||
+         key == Qt::Key_unknown;
+}
+
+constexpr int kModifierMask =
+    Qt::ShiftModifier | Qt::ControlModifier | Qt::AltModifier | Qt::MetaModifier;
+
+std::uint64_t edgeKey(std::uint32_t node, int chord) {
+  return (std::uint64_t{node} << 32) | static_cast<std::uint32_t>(chord);
+}
+
+} // namespace
+
+void invalidate() { g_generation.fetch_add(1, std::memory_order_relaxed); }
+
+std::uint64_t generation() {
+  return g_generation.load(std::memory_order_relaxed);
+}
+
+Accelerator::Accelerator(AC_Manager *manager, std::vector<QString> shortcuts)
+    : m_manager(manager), m_names(std::move(shortcuts)) {
+  if (m_manager) hookLoadShortcuts(m_manager);
+}
+
+void Accelerator::rebuild() {
+  static auto &rebuilds = metrics::counter("shortcuts.trie_rebuilds");
+  rebuilds.add();
+  m_edges.clear();
+  m_terminal.assign(1, -1);
+  m_node = 0;
+  m_generation = generation();
+  if (!m_manager) return;
+
+  for (int i = 0; i < static_cast<int>(m_names.size()); i++) {
+    const auto sequence = m_manager->keySequenceForShortcut(m_names[i]);
+    if (sequence.isEmpty()) continue;
+    std::uint32_t node = 0;
+    for (int c = 0; c < sequence.count(); c++) {
+      const int chord = sequence[c].toCombined();
+      auto [it, inserted] = m_edges.try_emplace(
+          edgeKey(node, chord), static_cast<std::uint32_t>(m_terminal.size()));
+      if (inserted) m_terminal.push_back(-1);
+      node = it->second;
+    }
+    if (m_terminal[node] == -1) {
+      m_terminal[node] = i;
+    } else {
+      TB_LOG_DEBUG(Actions, "Shortcut {} has the same keys as {}; ignoring it",
+                   m_names[i].toStdString(),
+                   m_names[m_terminal[node]].toStdString());
+    }
+  }
+}
+
+Match Accelerator::match(const QKeyEvent *event) {
+  static auto &matched = metrics::counter("shortcuts.matched");
+  if (m_generation != generation()) rebuild();
+  const int key = event->key();
+  if (isModifierKey(key)) {
+    return {m_node == 0 ? Match::None : Match::Partial, -1};
+  }
+  const int chord = key | (static_cast<int>(event->modifiers()) & kModifierMask);
+
+  auto it = m_edges.find(edgeKey(m_node, chord));
+  if (it == m_edges.end() && m_node != 0) {
+    // A dead end part way through a sequence starts over with this key.
+    m_node = 0;
+    it = m_edges.find(edgeKey(0, chord));
+  }
+  if (it == m_edges.end()) {
+    m_node = 0;
+    return {};
+  }
+  const auto node = it->second;
+  if (m_terminal[node] != -1) {
+    // Shortcuts that are also prefixes of longer ones fire straight away,
+    // as in AC_Manager.
+    m_node = 0;
+    matched.add();
+    return {Match::Full, m_terminal[node]};
+  }
+  m_node = node;
+  return {Match::Partial, -1};
+}
+
+} // namespace util::shortcuts
@@ -0,0 +1,354 @@
+#include "include/public/toon_boom/ext/tasks.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMetaObject>
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace util::tasks {
+
+struct Task {
+  std::function<void()> fn;
+  TaskGroup *group = nullptr;
+};
+
+struct TaskRunner {
+  static void run(Task *task) {
+    std::unique_ptr<Task> owned(task);
+    if (!task->group || !task->group->cancelled()) {
+      try {
+        task->fn();
+      } catch (const std::exception &e) {
+        TB_LOG_ERROR(General, "task threw: {}", e.what());
+      } catch (...) {
+        TB_LOG_ERROR(General, "task threw an unknown exception");
+      }
+    }
+    if (task->group) task->group->finishOne();
+  }
+};
+
+namespace {
+
+// Chase-Lev deque as formulated for C11 atomics by Le, Pop, Cohen and
+// Zappa Nardelli (PPoPP 2013). The owner pushes and pops at bottom; thieves
+// take from top.
+class WorkStealingDeque {
+public:
+  WorkStealingDeque() {
+    m_arrays.push_back(std::make_unique<Array>(256));
+    m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+  }
+
+  // Owner only.
+  void push(Task *task) {
+    const auto b = m_bottom.load(std::memory_order_relaxed);
+    const auto t = m_top.load(std::memory_order_acquire);
+    Array *array = m_array.load(std::memory_order_relaxed);
+    if (b - t > static_cast<std::int64_t>(array->capacity) - 1) {
+      array = grow(array, t, b);
+    }
+    array->put(b, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only.
+  Task *pop() {
+    const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+    Array *array = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = m_top.load(std::memory_order_relaxed);
+    if (t > b) {
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    Task *task = array->get(b);
+    if (t == b) {
+      // Last element: race the thieves for it.
+      if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+        task = nullptr;
+      }
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  // Any thread.
+  Task *steal() {
+    auto t = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const auto b = m_bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+    Array *array = m_array.load(std::memory_order_acquire);
+    Task *task = array->get(t);
+    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return task;
+  }
+
+private:
+  struct Array {
+    explicit Array(std::size_t n)
+        : capacity(n), slots(new std::atomic<Task *>[n]) {}
+    Task *get(std::int64_t i) const {
+      return slots[static_cast<std::size_t>(i) & (capacity - 1)].load(
+          std::memory_order_relaxed);
+    }
+    void put(std::int64_t i, Task *task) {
+      slots[static_cast<std::size_t>(i) & (capacity - 1)].store(
+          task, std::memory_order_relaxed);
+    }
+    std::size_t capacity; // power of two
+    std::unique_ptr<std::atomic<Task *>[]> slots;
+  };
+
+  Array *grow(Array *old, std::int64_t top, std::int64_t bottom) {
+    auto next = std::make_unique<Array>(old->capacity * 2);
+    for (auto i = top; i < bottom; ++i) next->put(i, old->get(i));
+    Array *raw = next.get();
+    m_array.store(raw, std::memory_order_release);
+    // A thief may still be reading the old array, so every array is kept
+    // until the deque goes away.
+    m_arrays.push_back(std::move(next));
+    return raw;
+  }
+
+  alignas(64) std::atomic<std::int64_t> m_top{0};
+  alignas(64) std::atomic<std::int64_t> m_bottom{0};
+  std::atomic<Array *> m_array{nullptr};
+  std::vector<std::unique_ptr<Array>> m_arrays; // owner only
+};
+
+struct Worker {
+  WorkStealingDeque deque;
+  unsigned index = 0;
+};
+
+thread_local Worker *t_worker = nullptr;
+
+class Pool {
+public:
+  // Leaked on purpose: the workers are never joined.
+  static Pool &instance() {
+    static Pool *pool = new Pool();
+    return *pool;
+  }
+
+  static bool configure(const Config &config) {
+    std::lock_guard lock(s_configMutex);
+    if (s_started) return false;
+    s_config = config;
+    return true;
+  }
+
+  unsigned workerCount() const { return static_cast<unsigned>(m_workers.size()); }
+
+  void submit(Task *task) {
+    if (t_worker) {
+      t_worker->deque.push(task);
+    } else {
+      std::lock_guard lock(m_injectMutex);
+      m_inject.push_back(task);
+    }
+    wake();
+  }
+
+  // Runs one task from anywhere in the pool. Returns false if there was none.
+  bool runOne(Worker *self) {
+    Task *task = self ? self->deque.pop() : nullptr;
+    if (!task) task = takeInjected();
+    if (!task) task = stealFromOthers(self);
+    if (!task) return false;
+    TaskRunner::run(task);
+    return true;
+  }
+
+private:
+  Pool() {
+    unsigned count;
+    {
+      std::lock_guard lock(s_configMutex);
+      s_started = true;
+      count = s_config.workers;
+    }
+    if (count == 0) {
+      const unsigned hardware = std::thread::hardware_concurrency();
+      count = hardware > 1 ? hardware - 1 : 1;
+    }
+    m_workers.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+      auto worker = std::make_unique<Worker>();
+      worker->index = i;
+      m_workers.push_back(std::move(worker));
+    }
+    for (auto &worker : m_workers) {
+      std::thread([this, w = worker.get()]() { loop(w); }).detach();
+    }
+  }
+
+  void loop(Worker *self) {
+    t_worker = self;
+    for (;;) {
+      // The epoch is read before looking for work and submitters bump it
+      // after queueing, so anything queued after the search below wakes us.
+      const auto seen = m_epoch.load(std::memory_order_seq_cst);
+      if (runOne(self)) continue;
+      std::unique_lock lock(m_sleepMutex);
+      m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+      m_wake.wait(lock, [&]() {
+        return m_epoch.load(std::memory_order_seq_cst) != seen;
+      });
+      m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  void wake() {
+    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_seq_cst) == 0) return;
+    { std::lock_guard lock(m_sleepMutex); }
+    m_wake.notify_one();
+  }
+
+  Task *takeInjected() {
+    std::lock_guard lock(m_injectMutex);
+    if (m_inject.empty()) return nullptr;
+    Task *task = m_inject.front();
+    m_inject.pop_front();
+    return task;
+  }
+
+  Task *stealFromOthers(Worker *self) {
+    thread_local std::minstd_rand rng{std::random_device{}()};
+    const auto n = m_workers.size();
+    const auto start = static_cast<std::size_t>(rng()) % n;
+    for (std::size_t i = 0; i < n; ++i) {
+      Worker *victim = m_workers[(start + i) % n].get();
+      if (victim == self) continue;
+      if (Task *task = victim->deque.steal()) return task;
+    }
+    return nullptr;
+  }
+
+  static inline std::mutex s_configMutex;
+  static inline Config s_config;
+  static inline bool s_started = false;
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+
+  std::mutex m_injectMutex;
+  std::deque<Task *> m_inject;
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wake;
+  std::atomic<std::uint64_t> m_epoch{0};
+  std::atomic<unsigned> m_sleepers{0};
+};
+
+} // namespace
+
+bool configure(const Config &config) { return Pool::configure(config); }
+
+unsigned workerCount() { return Pool::instance().workerCount(); }
+
+bool onWorkerThread() { return t_worker != nullptr; }
+
+void post(std::function<void()> fn) {
+  Pool::instance().submit(new Task{std::move(fn), nullptr});
+}
+
+bool postToGui(std::function<void()> fn) {
+  QCoreApplication *app = QCoreApplication::instance();
+  if (!app) return false;
+  return QMetaObject::invokeMethod(app, std::move(fn), Qt::QueuedConnection);
+}
+
+void TaskGroup::run(std::function<void()> fn) {
+  m_pending.fetch_add(1, std::memory_order_relaxed);
+  Pool::instance().submit(new Task{std::move(fn), this});
+}
+
+void TaskGroup::finishOne() {
+  // The last decrement and its notify both happen under the mutex, so once
+  // wait() has taken the mutex and seen zero, nothing here touches the group
+  // again and its owner may destroy it.
+  std::lock_guard lock(m_mutex);
+  if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    m_done.notify_all();
+  }
+}
+
+void TaskGroup::wait() {
+  if (t_worker) {
+    // Blocking a worker could starve the very tasks we are waiting for.
+    auto &pool = Pool::instance();
+    while (m_pending.load(std::memory_order_acquire) != 0) {
+      if (!pool.runOne(t_worker)) std::this_thread::yield();
+    }
+  }
+  // Even when the count is already zero, the last finishOne() may still hold
+  // the mutex; returning before it lets go would free it from under it.
+  std::unique_lock lock(m_mutex);
+  m_done.wait(lock, [this]() {
+    return m_pending.load(std::memory_order_acquire) == 0;
+  });
+}
+
+void parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                 const std::function<void(std::size_t, std::size_t)> &fn) {
+  if (begin >= end) return;
+  grain = std::max<std::size_t>(grain, 1);
+  const std::size_t chunks = (end - begin + grain - 1) / grain;
+  if (chunks == 1) {
+    fn(begin, end);
+    return;
+  }
+
+  // Helpers that start after every chunk is claimed touch nothing but this
+  // state, which they keep alive themselves.
+  struct State {
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+  };
+  auto state = std::make_shared<State>();
+  const std::size_t total = chunks;
+  auto work = [state, total, begin, end, grain, &fn]() {
+    for (;;) {
+      const auto i = state->next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= total) return;
+      const auto chunkBegin = begin + i * grain;
+      fn(chunkBegin, std::min(end, chunkBegin + grain));
+      if (state->done.fetch_add(1, std::memory_order_acq_rel) + 1 == total) {
+        std::lock_guard lock(state->mutex);
+        state->finished.notify_all();
+      }
+    }
+  };
+
+  auto &pool = Pool::instance();
+  const auto helpers = std::min<std::size_t>(pool.workerCount(), chunks - 1);
+  for (std::size_t i = 0; i < helpers; ++i) pool.submit(new Task{work, nullptr});
+  work();
+
+  // Every chunk is claimed; the ones still running belong to threads that
+  // have already started, so this cannot wait on a task stuck in a queue.
+  std::unique_lock lock(state->mutex);
+  state->finished.wait(lock, [&]() {
+    return state->done.load(std::memory_order_acquire) == total;
+  });
+}
+
+} // namespace util::tasks
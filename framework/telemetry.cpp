@@ -0,0 +1,129 @@
+#include "include/public/toon_boom/ext/telemetry.hpp"
+#include "include/public/toon_boom/ext/metrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <windows.h>
+
+namespace util::telemetry {
+namespace {
+
+constexpr auto kMetricsInterval = std::chrono::seconds(1);
+
+class Channel {
+public:
+  // Leaked on purpose, like the log drain thread: the mapping must outlive
+  // every thread that might still publish during shutdown.
+  static Channel &instance() {
+    static Channel *channel = new Channel();
+    return *channel;
+  }
+
+  bool attached() const { return m_writer != nullptr; }
+  bool rendersConsole() const { return m_writer && m_rendersConsole; }
+
+  void open(bool rendersConsole) {
+    m_rendersConsole = rendersConsole;
+    const auto pid = GetCurrentProcessId();
+    const auto size = mappingSize(kDefaultCapacity);
+    HANDLE mapping = CreateFileMappingA(
+        INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32),
+        static_cast<DWORD>(size), mappingName(pid).c_str());
+    if (!mapping) return;
+    void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view) {
+      CloseHandle(mapping);
+      return;
+    }
+    m_event = CreateEventA(NULL, FALSE, FALSE, eventName(pid).c_str());
+    RingWriter::create(view, static_cast<std::uint32_t>(kDefaultCapacity));
+    m_writer = new RingWriter(view);
+    // The mapping handle and view are kept for the life of the process.
+  }
+
+  bool publish(const RecordHeader &header, std::string_view payload) {
+    if (!m_writer) return false;
+    // The log drain thread and the metrics thread both publish; the ring
+    // itself has a single producer.
+    bool wake;
+    bool written;
+    {
+      std::lock_guard lock(m_mutex);
+      written = m_writer->write(header, payload);
+      wake = m_writer->readerWaiting();
+    }
+    if (wake && m_event) SetEvent(m_event);
+    std::call_once(m_metricsStarted, [this]() {
+      // Started from the first publish rather than from open(), which runs
+      // under the loader lock.
+      std::thread([this]() { publishMetrics(); }).detach();
+    });
+    return written;
+  }
+
+private:
+  Channel() = default;
+
+  void publishMetrics() {
+    std::string last;
+    for (;;) {
+      std::this_thread::sleep_for(kMetricsInterval);
+      auto json = metrics::toJson(metrics::snapshot());
+      if (json == last) continue;
+      const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch());
+      RecordHeader header{};
+      header.kind = RecordKind::Metrics;
+      header.threadId = GetCurrentThreadId();
+      header.timestamp = now.count();
+      std::memcpy(header.source, "metrics", 7);
+      publish(header, json);
+      last = std::move(json);
+    }
+  }
+
+  RingWriter *m_writer = nullptr;
+  bool m_rendersConsole = false;
+  HANDLE m_event = NULL;
+  std::mutex m_mutex;
+  std::once_flag m_metricsStarted;
+};
+
+struct TelemetryFromEnvironment {
+  TelemetryFromEnvironment() {
+    char value[8] = {};
+    if (GetEnvironmentVariableA("TB_EXT_TELEMETRY", value, sizeof(value)) == 0) {
+      return;
+    }
+    Channel::instance().open(std::strcmp(value, "console") == 0);
+  }
+} telemetry_from_environment;
+
+} // namespace
+
+bool attached() { return Channel::instance().attached(); }
+
+bool rendersConsole() { return Channel::instance().rendersConsole(); }
+
+bool publish(RecordKind kind, std::uint8_t level, std::string_view source,
+             std::uint32_t threadId, std::int64_t timestampNs,
+             std::string_view payload) {
+  auto &channel = Channel::instance();
+  if (!channel.attached()) return false;
+  RecordHeader header{};
+  header.kind = kind;
+  header.level = level;
+  header.threadId = threadId;
+  header.timestamp = timestampNs;
+  std::memcpy(header.source, source.data(),
+              std::min(source.size(), sizeof(header.source)));
+  return channel.publish(header, payload);
+}
+
+} // namespace util::telemetry
@@ -0,0 +1,197 @@
+#include "include/public/toon_boom/ext/toolbar_def.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+#include "include/public/toon_boom/ext/metrics.hpp"
+#include "include/public/toon_boom/ext/util.hpp"
+#include "include/public/toon_boom/ext/xml_blob.hpp"
+
+#include <QtCore/QTextStream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace util::toolbar {
+namespace {
+
+struct CacheEntry {
+  QString source;
+  std::shared_ptr<const Definition> def;
+};
+
+struct Cache {
+  std::unordered_map<std::uint64_t, std::vector<CacheEntry>> entries;
+  std::unordered_set<std::uint64_t> loaded;
+  // Embedded blobs live in static storage, so their address identifies them.
+  std::unordered_map<const std::uint8_t *, std::shared_ptr<const Definition>> blobs;
+};
+
+// Leaked like the other framework singletons; QDomDocument teardown after
+// Qt has gone is not safe.
+Cache &cache() {
+  static Cache *instance = new Cache();
+  return *instance;
+}
+
+std::uint64_t hashOf(const QString &text) {
+  return fnv1a(std::span(reinterpret_cast<const char16_t *>(text.utf16()),
+                         static_cast<std::size_t>(text.size())));
+}
+
+// Fills in everything but the hash from def->document.
+bool fill(Definition *def, QString &error) {
+  auto root = def->document.documentElement();
+  if (root.tagName() == "toolbar") {
+    // Callers and AC_Manager both expect the <toolbars> wrapper.
+    QDomDocument wrapped;
+    auto toolbars = wrapped.createElement("toolbars");
+    toolbars.appendChild(wrapped.importNode(root, true));
+    wrapped.appendChild(toolbars);
+    def->document = wrapped;
+  }
+  auto toolbar = def->toolbarElement();
+  if (toolbar.isNull()) {
+    error = "no <toolbar> element";
+    return false;
+  }
+
+  def->id = toolbar.attribute("id");
+  def->text = toolbar.attribute("text");
+  def->customizable = toolbar.attribute("customizable") == "true";
+  def->visible = toolbar.attribute("visible", "true") == "true";
+  for (auto node = toolbar.firstChildElement(); !node.isNull();
+       node = node.nextSiblingElement()) {
+    Item item{node.attribute("id"), node.attribute("slot"),
+              node.attribute("icon"), node.attribute("responder"),
+              node.attribute("text")};
+    def->buttonIds.append(item.id);
+    def->items.push_back(std::move(item));
+  }
+  return true;
+}
+
+std::shared_ptr<Definition> build(const QString &xml, QString &error) {
+  auto def = std::make_shared<Definition>();
+  QString message;
+  int line = 0;
+  int column = 0;
+  if (!def->document.setContent(xml, &message, &line, &column)) {
+    error = QString("line %1, column %2: %3").arg(line).arg(column).arg(message);
+    return nullptr;
+  }
+  return fill(def.get(), error) ? def : nullptr;
+}
+
+QDomDocument buildDocument(std::span<const std::uint8_t> blob, QString &error) {
+  xml_blob::Decoded decoded;
+  if (!xml_blob::decode(blob, decoded)) {
+    error = "malformed or out of date embedded XML; rebuild it";
+    return QDomDocument();
+  }
+  // Each distinct string is converted once; tags and attribute names repeat
+  // on every item.
+  std::vector<QString> strings;
+  strings.reserve(decoded.strings.size());
+  for (auto text : decoded.strings) {
+    strings.push_back(QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size())));
+  }
+
+  QDomDocument document;
+  // decode() has checked the preorder forms a single tree.
+  std::vector<std::pair<QDomNode, std::uint32_t>> open{{document, 1}};
+  for (const auto &record : decoded.nodes) {
+    while (open.back().second == 0) open.pop_back();
+    open.back().second--;
+    auto element = document.createElement(strings[record.tag]);
+    for (std::uint32_t i = 0; i < record.attributeCount; i++) {
+      const auto &[name, value] = decoded.attributes[record.firstAttribute + i];
+      element.setAttribute(strings[name], strings[value]);
+    }
+    open.back().first.appendChild(element);
+    open.emplace_back(element, record.childCount);
+  }
+  return document;
+}
+
+} // namespace
+
+std::shared_ptr<const Definition> compile(const QString &xml, QString *error) {
+  static auto &hits = metrics::counter("toolbar.cache_hits");
+  static auto &compiled = metrics::counter("toolbar.compiled");
+  const auto hash = hashOf(xml);
+  auto &bucket = cache().entries[hash];
+  for (const auto &entry : bucket) {
+    if (entry.source == xml) {
+      hits.add();
+      return entry.def;
+    }
+  }
+
+  QString message;
+  auto def = build(xml, message);
+  if (!def) {
+    TB_LOG_ERROR(Toolbar, "Could not compile toolbar: {}",
+                 message.toStdString());
+    if (error) *error = message;
+    return nullptr;
+  }
+  def->hash = hash;
+  compiled.add();
+  TB_LOG_DEBUG(Toolbar, "Compiled toolbar {} ({} items)", def->id.toStdString(),
+               def->items.size());
+  bucket.push_back({xml, def});
+  return def;
+}
+
+std::shared_ptr<const Definition> compile(const QDomElement &element,
+                                          QString *error) {
+  QString xml;
+  QTextStream stream(&xml);
+  element.save(stream, -1);
+  return compile(xml, error);
+}
+
+QDomDocument loadDocument(std::span<const std::uint8_t> blob, QString *error) {
+  QString message;
+  auto document = buildDocument(blob, message);
+  if (document.isNull() && error) *error = message;
+  return document;
+}
+
+std::shared_ptr<const Definition> load(std::span<const std::uint8_t> blob,
+                                       QString *error) {
+  static auto &hits = metrics::counter("toolbar.cache_hits");
+  static auto &loaded = metrics::counter("toolbar.loaded_embedded");
+  auto &cached = cache().blobs[blob.data()];
+  if (cached) {
+    hits.add();
+    return cached;
+  }
+
+  QString message;
+  auto def = std::make_shared<Definition>();
+  def->document = buildDocument(blob, message);
+  if (def->document.isNull() || !fill(def.get(), message)) {
+    TB_LOG_ERROR(Toolbar, "Could not load embedded toolbar: {}",
+                 message.toStdString());
+    if (error) *error = message;
+    cache().blobs.erase(blob.data());
+    return nullptr;
+  }
+  def->hash = fnv1a(blob);
+  loaded.add();
+  TB_LOG_DEBUG(Toolbar, "Loaded embedded toolbar {} ({} items)",
+               def->id.toStdString(), def->items.size());
+  cached = def;
+  return def;
+}
+
+bool isLoaded(const Definition &def) {
+  return cache().loaded.contains(def.hash);
+}
+
+void markLoaded(const Definition &def) { cache().loaded.insert(def.hash); }
+
+void clearCache() {
+  cache().entries.clear();
+  cache().blobs.clear();
+}
+
+} // namespace util::toolbar
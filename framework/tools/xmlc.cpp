@@ -0,0 +1,305 @@
+// toonboom_xmlc: validates toolbar/menu XML and writes it out as a C++ header
+// holding the util::xml_blob encoding. Run by toonboom_embed_xml(); see
+// xml_blob.hpp for the format.
+//
+//   toonboom_xmlc <input.xml> <output.hpp> <identifier>
+
+#include "../include/public/toon_boom/ext/xml_blob.hpp"
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using util::xml_blob::Node;
+
+namespace {
+
+struct ParseError : std::runtime_error {
+  ParseError(int line, const std::string &message)
+      : std::runtime_error(message), line(line) {}
+  int line;
+};
+
+// Just enough XML for Toon Boom's toolbar and menu files: elements,
+// attributes, comments, the XML declaration and a DOCTYPE. Character data
+// other than whitespace is rejected rather than silently dropped.
+class Parser {
+public:
+  explicit Parser(std::string text) : m_text(std::move(text)) {}
+
+  Node parseDocument() {
+    skipMisc();
+    if (!startsWith("<")) fail("expected the root element");
+    Node root = parseElement();
+    skipMisc();
+    if (m_at != m_text.size()) fail("content after the root element");
+    return root;
+  }
+
+private:
+  [[noreturn]] void fail(const std::string &message) const {
+    throw ParseError(m_line, message);
+  }
+
+  bool startsWith(std::string_view prefix) const {
+    return m_text.compare(m_at, prefix.size(), prefix) == 0;
+  }
+
+  void advance(std::size_t count) {
+    for (std::size_t i = 0; i < count && m_at < m_text.size(); i++) {
+      if (m_text[m_at++] == '\n') m_line++;
+    }
+  }
+
+  void skipWhitespace() {
+    while (m_at < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_at]))) {
+      advance(1);
+    }
+  }
+
+  void skipPast(std::string_view terminator) {
+    auto end = m_text.find(terminator, m_at);
+    if (end == std::string::npos) fail("unterminated markup");
+    advance(end + terminator.size() - m_at);
+  }
+
+  // Whitespace, comments, processing instructions and DOCTYPE.
+  void skipMisc() {
+    for (;;) {
+      skipWhitespace();
+      if (startsWith("<!--")) {
+        skipPast("-->");
+      } else if (startsWith("<?")) {
+        skipPast("?>");
+      } else if (startsWith("<!DOCTYPE")) {
+        skipPast(">");
+      } else {
+        return;
+      }
+    }
+  }
+
+  std::string parseName() {
+    auto start = m_at;
+    while (m_at < m_text.size()) {
+      unsigned char c = m_text[m_at];
+      if (!std::isalnum(c) && c != '_' && c != '-' && c != '.' && c != ':' && c < 0x80) break;
+      advance(1);
+    }
+    if (start == m_at) fail("expected a name");
+    return m_text.substr(start, m_at - start);
+  }
+
+  void appendUtf8(std::string &out, unsigned long code) {
+    if (code < 0x80) {
+      out += static_cast<char>(code);
+    } else if (code < 0x800) {
+      out += static_cast<char>(0xC0 | (code >> 6));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      out += static_cast<char>(0xE0 | (code >> 12));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x110000) {
+      out += static_cast<char>(0xF0 | (code >> 18));
+      out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+      fail("character reference out of range");
+    }
+  }
+
+  std::string unescape(std::string_view raw) {
+    std::string out;
+    for (std::size_t i = 0; i < raw.size(); i++) {
+      if (raw[i] != '&') {
+        if (raw[i] == '<') fail("'<' in attribute value");
+        out += raw[i];
+        continue;
+      }
+      auto end = raw.find(';', i);
+      if (end == std::string_view::npos) fail("unterminated entity");
+      auto entity = raw.substr(i + 1, end - i - 1);
+      if (entity == "amp") out += '&';
+      else if (entity == "lt") out += '<';
+      else if (entity == "gt") out += '>';
+      else if (entity == "quot") out += '"';
+      else if (entity == "apos") out += '\'';
+      else if (entity.size() > 1 && entity[0] == '#') {
+        const bool hex = entity[1] == 'x';
+        std::string digits(entity.substr(hex ? 2 : 1));
+        char *parsedEnd = nullptr;
+        auto code = std::strtoul(digits.c_str(), &parsedEnd, hex ? 16 : 10);
+        if (digits.empty() || *parsedEnd != '\0') fail("bad character reference");
+        appendUtf8(out, code);
+      } else {
+        fail("unknown entity &" + std::string(entity) + ";");
+      }
+      i = end;
+    }
+    return out;
+  }
+
+  Node parseElement() {
+    advance(1); // '<'
+    Node node;
+    node.tag = parseName();
+    for (;;) {
+      skipWhitespace();
+      if (startsWith("/>")) {
+        advance(2);
+        return node;
+      }
+      if (startsWith(">")) {
+        advance(1);
+        break;
+      }
+      auto name = parseName();
+      for (const auto &[existing, value] : node.attributes) {
+        if (existing == name) fail("duplicate attribute " + name);
+      }
+      skipWhitespace();
+      if (!startsWith("=")) fail("expected '=' after " + name);
+      advance(1);
+      skipWhitespace();
+      if (m_at >= m_text.size() || (m_text[m_at] != '"' && m_text[m_at] != '\'')) {
+        fail("expected a quoted value for " + name);
+      }
+      const char quote = m_text[m_at];
+      advance(1);
+      auto end = m_text.find(quote, m_at);
+      if (end == std::string::npos) fail("unterminated value for " + name);
+      auto value = unescape(std::string_view(m_text).substr(m_at, end - m_at));
+      advance(end + 1 - m_at);
+      node.attributes.emplace_back(std::move(name), std::move(value));
+    }
+
+    for (;;) {
+      skipMisc();
+      if (m_at >= m_text.size()) fail("unclosed <" + node.tag + ">");
+      if (startsWith("</")) {
+        advance(2);
+        if (parseName() != node.tag) fail("mismatched </...> for <" + node.tag + ">");
+        skipWhitespace();
+        if (!startsWith(">")) fail("expected '>'");
+        advance(1);
+        return node;
+      }
+      if (startsWith("<![CDATA[")) fail("CDATA is not supported");
+      if (!startsWith("<")) fail("text content is not supported");
+      node.children.push_back(parseElement());
+    }
+  }
+
+  std::string m_text;
+  std::size_t m_at = 0;
+  int m_line = 1;
+};
+
+// Catches the mistakes that otherwise only show up as a silently empty
+// toolbar inside Harmony.
+void validate(const Node &root, std::vector<std::string> &errors) {
+  const bool isToolbars = root.tag == "toolbars" || root.tag == "toolbar";
+  const bool isMenus = root.tag == "menus" || root.tag == "menu";
+  if (!isToolbars && !isMenus) {
+    errors.push_back("root element must be <toolbars>, <toolbar>, <menus> or <menu>, not <" +
+                     root.tag + ">");
+    return;
+  }
+  auto attribute = [](const Node &node, const std::string &name) -> const std::string * {
+    for (const auto &[key, value] : node.attributes) {
+      if (key == name) return &value;
+    }
+    return nullptr;
+  };
+  auto checkToolbar = [&](const Node &toolbar) {
+    if (!attribute(toolbar, "id")) errors.push_back("<toolbar> without an id");
+    for (const auto &item : toolbar.children) {
+      if (item.tag != "item") continue;
+      auto id = attribute(item, "id");
+      if (!id || id->empty()) {
+        errors.push_back("<item> without an id in toolbar " +
+                         (attribute(toolbar, "id") ? *attribute(toolbar, "id") : "?"));
+      } else if (!attribute(item, "slot")) {
+        errors.push_back("item " + *id + " has no slot");
+      }
+    }
+  };
+  if (root.tag == "toolbar") {
+    checkToolbar(root);
+  } else if (root.tag == "toolbars") {
+    if (root.children.empty()) errors.push_back("<toolbars> is empty");
+    for (const auto &child : root.children) {
+      if (child.tag == "toolbar") checkToolbar(child);
+    }
+  }
+}
+
+std::string readFile(const char *path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) throw std::runtime_error(std::string("cannot open ") + path);
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  auto text = contents.str();
+  if (text.rfind("\xEF\xBB\xBF", 0) == 0) text.erase(0, 3); // UTF-8 BOM
+  return text;
+}
+
+void writeHeader(const char *path, const std::string &identifier, const char *source,
+                 const std::vector<std::uint8_t> &blob) {
+  std::ostringstream out;
+  out << "// Generated by toonboom_xmlc from " << source << ". Do not edit.\n"
+      << "#pragma once\n#include <cstdint>\n\n"
+      << "namespace embedded_xml {\n"
+      << "inline constexpr std::uint8_t " << identifier << "[] = {";
+  for (std::size_t i = 0; i < blob.size(); i++) {
+    if (i % 16 == 0) out << "\n   ";
+    out << ' ' << static_cast<unsigned>(blob[i]) << ',';
+  }
+  out << "\n};\n} // namespace embedded_xml\n";
+
+  // Always written; the build copies it over the real header only when it
+  // changed, so dependents are not rebuilt for nothing.
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << out.str();
+  if (!file) throw std::runtime_error(std::string("cannot write ") + path);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 4) {
+    std::cerr << "usage: toonboom_xmlc <input.xml> <output.hpp> <identifier>" << std::endl;
+    return 2;
+  }
+  try {
+    Parser parser(readFile(argv[1]));
+    Node root = parser.parseDocument();
+    std::vector<std::string> errors;
+    validate(root, errors);
+    for (const auto &error : errors) {
+      std::cerr << argv[1] << ": error: " << error << std::endl;
+    }
+    if (!errors.empty()) return 1;
+
+    auto blob = util::xml_blob::encode(root);
+    util::xml_blob::Decoded check;
+    if (!util::xml_blob::decode(blob, check)) {
+      std::cerr << argv[1] << ": error: encoded form does not round-trip" << std::endl;
+      return 1;
+    }
+    writeHeader(argv[2], argv[3], argv[1], blob);
+  } catch (const ParseError &e) {
+    std::cerr << argv[1] << "(" << e.line << "): error: " << e.what() << std::endl;
+    return 1;
+  } catch (const std::exception &e) {
+    std::cerr << argv[1] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,218 @@
+#include "include/public/toon_boom/ext/trace.hpp"
+
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+namespace util::trace {
+namespace {
+
+constexpr std::size_t kChunkEvents = 1024;
+// 256 chunks * 1024 events * 64 bytes = 16 MiB per thread at most.
+constexpr std::size_t kMaxChunksPerThread = 256;
+
+struct Chunk {
+  std::atomic<std::size_t> count{0};
+  std::atomic<Chunk *> next{nullptr};
+  Event events[kChunkEvents];
+};
+
+// Owned by the Tracer and never freed, so events from threads that have
+// exited are still exported.
+struct ThreadBuffer {
+  std::uint32_t threadId = 0;
+  Chunk first;
+  Chunk *tail = &first; // producer-only
+  std::size_t chunks = 1; // producer-only
+  std::atomic<std::uint64_t> dropped{0};
+};
+
+void appendEscaped(std::string &out, std::string_view text) {
+  for (char c : text) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        std::format_to(std::back_inserter(out), "\\u{:04x}",
+                       static_cast<unsigned>(c));
+      } else {
+        out.push_back(c);
+      }
+    }
+  }
+}
+
+class Tracer {
+public:
+  // Leaked on purpose, like the logger: threads may still record while the
+  // DLL's statics are being torn down.
+  static Tracer &instance() {
+    static Tracer *tracer = new Tracer();
+    return *tracer;
+  }
+
+  ThreadBuffer *registerThread() {
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->threadId = static_cast<std::uint32_t>(GetCurrentThreadId());
+    auto *raw = buffer.get();
+    std::lock_guard lock(m_buffersMutex);
+    m_buffers.push_back(std::move(buffer));
+    return raw;
+  }
+
+  void setPath(const std::filesystem::path &path) {
+    std::lock_guard lock(m_pathMutex);
+    m_path = path;
+  }
+
+  std::filesystem::path path() {
+    std::lock_guard lock(m_pathMutex);
+    return m_path;
+  }
+
+  std::uint64_t dropped() {
+    std::lock_guard lock(m_buffersMutex);
+    std::uint64_t total = 0;
+    for (const auto &buffer : m_buffers) {
+      total += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  bool writeJson(const std::filesystem::path &path) {
+    std::error_code ec;
+    if (path.has_parent_path()) {
+      std::filesystem::create_directories(path.parent_path(), ec);
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      std::fprintf(stderr, "[trace] could not open %s\n",
+                   path.string().c_str());
+      return false;
+    }
+
+    const auto pid = GetCurrentProcessId();
+    std::string out;
+    out.reserve(1 << 16);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto flushIfLarge = [&]() {
+      if (out.size() < (1 << 16)) return;
+      file.write(out.data(), static_cast<std::streamsize>(out.size()));
+      out.clear();
+    };
+
+    std::lock_guard lock(m_buffersMutex);
+    for (const auto &buffer : m_buffers) {
+      for (const Chunk *chunk = &buffer->first; chunk;
+           chunk = chunk->next.load(std::memory_order_acquire)) {
+        const auto count = chunk->count.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < count; ++i) {
+          const Event &event = chunk->events[i];
+          if (!first) out.push_back(',');
+          first = false;
+          out += "\n{\"name\":\"";
+          appendEscaped(out, event.name);
+          out += "\",\"cat\":\"";
+          appendEscaped(out, event.category);
+          std::format_to(std::back_inserter(out),
+                         "\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+                         "\"pid\":{},\"tid\":{}",
+                         event.startNs / 1000.0, event.durationNs / 1000.0,
+                         pid, buffer->threadId);
+          if (event.detail[0] != '\0') {
+            out += ",\"args\":{\"detail\":\"";
+            appendEscaped(out, event.detail);
+            out += "\"}";
+          }
+          out.push_back('}');
+          flushIfLarge();
+        }
+      }
+    }
+    out += "\n]}\n";
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    return file.good();
+  }
+
+private:
+  Tracer() = default;
+
+  std::mutex m_buffersMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+
+  std::mutex m_pathMutex;
+  std::filesystem::path m_path;
+};
+
+thread_local ThreadBuffer *t_buffer = nullptr;
+
+// Reads TB_EXT_TRACE_FILE when the framework is loaded. Whatever path is set
+// when the framework is unloaded gets the trace.
+struct TraceFromEnvironment {
+  TraceFromEnvironment() {
+    char value[MAX_PATH] = {};
+    const DWORD n = GetEnvironmentVariableA("TB_EXT_TRACE_FILE", value, MAX_PATH);
+    if (n == 0 || n >= MAX_PATH) return;
+    start(std::filesystem::path(value));
+  }
+  ~TraceFromEnvironment() {
+    auto path = Tracer::instance().path();
+    if (!path.empty()) Tracer::instance().writeJson(path);
+  }
+} trace_from_environment;
+
+} // namespace
+
+namespace detail {
+
+std::atomic<bool> g_enabled{false};
+
+void record(const Event &event) {
+  ThreadBuffer *buffer = t_buffer;
+  if (!buffer) buffer = t_buffer = Tracer::instance().registerThread();
+
+  Chunk *chunk = buffer->tail;
+  auto count = chunk->count.load(std::memory_order_relaxed);
+  if (count == kChunkEvents) {
+    if (buffer->chunks == kMaxChunksPerThread) {
+      buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    auto *next = new Chunk();
+    chunk->next.store(next, std::memory_order_release);
+    buffer->tail = chunk = next;
+    ++buffer->chunks;
+    count = 0;
+  }
+  chunk->events[count] = event;
+  chunk->count.store(count + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+void start(const std::filesystem::path &path) {
+  if (!path.empty()) Tracer::instance().setPath(path);
+  detail::g_enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop() { detail::g_enabled.store(false, std::memory_order_relaxed); }
+
+bool writeJson(const std::filesystem::path &path) {
+  return Tracer::instance().writeJson(path);
+}
+
+std::uint64_t dropped() { return Tracer::instance().dropped(); }
+
+} // namespace util::trace
@@ -2,10 +2,10 @@
 
 namespace util::debug {
 std::string addrToHex(void* addr) {
-  return std::format("0x{:010X}", reinterpret_cast<uintptr_t>(addr));
+  return std::string(toHex(addr).view());
 }
 
 std::string constAddrToHex(const void* addr) {
-  return std::format("0x{:010X}", reinterpret_cast<const uintptr_t>(addr));
+  return std::string(toHex(addr).view());
 }
 } // namespace util::debug
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "include/public/toon_boom/ext/validation.hpp"
+#include "include/public/toon_boom/ac_manager.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+#include "include/public/toon_boom/ext/tasks.hpp"
+
+#include <algorithm>
+
+namespace util::actions {
+namespace {
+
+// Managers with a revalidation queued. Only touched on the GUI thread.
+std::vector<AC_Manager *> &pendingManagers() {
+  static auto *managers = new std::vector<AC_Manager *>();
+  return *managers;
+}
+
+void revalidate() {
+  static auto &passes = metrics::counter("actions.revalidations");
+  auto managers = std::move(pendingManagers());
+  pendingManagers().clear();
+  for (auto *manager : managers) {
+    passes.add();
+    manager->updateToolbars();
+  }
+}
+
+} // namespace
+
+void scheduleRevalidation(AC_Manager *manager) {
+  static auto &coalesced = metrics::counter("actions.revalidations_coalesced");
+  if (!manager) return;
+  auto &managers = pendingManagers();
+  if (std::find(managers.begin(), managers.end(), manager) != managers.end()) {
+    coalesced.add();
+    return;
+  }
+  const bool first = managers.empty();
+  managers.push_back(manager);
+  if (first && !tasks::postToGui(revalidate)) {
+    // No event loop yet; nothing is on screen to revalidate.
+    TB_LOG_DEBUG(Toolbar, "No QCoreApplication, dropping revalidation");
+    managers.clear();
+  }
+}
+
+} // namespace util::actions
@@ -0,0 +1,104 @@
+#include "include/public/toon_boom/ext/view_registry.hpp"
+#include "include/public/toon_boom/PLUG_Services.hpp"
+#include "include/public/toon_boom/ext/log.hpp"
+#include "include/public/toon_boom/ext/metrics.hpp"
+#include "include/public/toon_boom/ext/trace.hpp"
+
+namespace util::layout {
+
+ViewRegistry &ViewRegistry::instance() {
+  // Leaked: TULayoutManager owns the views and may outlive static
+  // destruction.
+  static auto *registry = new ViewRegistry();
+  return *registry;
+}
+
+ViewHandle ViewRegistry::add(std::string_view id, const QString &displayName,
+                             std::function<TULayoutView *()> factory,
+                             const ViewOptions &options) {
+  if (auto existing = find(id); existing.valid()) {
+    TB_LOG_DEBUG(Layout, "View {} is already registered", id);
+    return existing;
+  }
+  m_entries.push_back({std::string(id), displayName, std::move(factory), options});
+  ViewHandle handle{static_cast<std::uint32_t>(m_entries.size())};
+  m_byId.emplace(m_entries.back().id, handle);
+  return handle;
+}
+
+ViewHandle ViewRegistry::find(std::string_view id) const {
+  auto it = m_byId.find(id);
+  return it == m_byId.end() ? ViewHandle{} : it->second;
+}
+
+const ViewRegistry::Entry *ViewRegistry::entry(ViewHandle handle) const {
+  if (!handle.valid() || handle.index > m_entries.size()) return nullptr;
+  return &m_entries[handle.index - 1];
+}
+
+TULayoutView *ViewRegistry::view(ViewHandle handle) const {
+  auto *found = entry(handle);
+  return found ? found->view : nullptr;
+}
+
+std::chrono::nanoseconds ViewRegistry::creationTime(ViewHandle handle) const {
+  auto *found = entry(handle);
+  return found ? found->creationTime : std::chrono::nanoseconds{0};
+}
+
+bool ViewRegistry::create(Entry &entry) {
+  static auto &created = metrics::counter("layout.views_registered_created");
+  static auto &latency = metrics::histogram("layout.view_create_ns");
+  auto lm = PLUG_Services::getLayoutManager();
+  if (!lm) {
+    TB_LOG_ERROR(Layout, "No layout manager to add view {} to", entry.id);
+    return false;
+  }
+
+  TB_TRACE_SCOPE("layout", "createView");
+  const auto start = std::chrono::steady_clock::now();
+  auto *view = entry.factory();
+  if (!view) {
+    TB_LOG_ERROR(Layout, "Factory for view {} returned null", entry.id);
+    return false;
+  }
+  const bool added = lm->addArea(entry.id.c_str(), entry.displayName, view, true,
+                                 true, entry.options.docked,
+                                 entry.options.minSize, entry.options.useMinSize,
+                                 false, true, true);
+  if (!added) {
+    // Not deleted: the layout manager may already hold on to it. Nor
+    // retried, which would leak another view on every raise().
+    TB_LOG_WARN(Layout, "Failed to add view {} to layout!", entry.id);
+    entry.failed = true;
+    entry.factory = nullptr;
+    return false;
+  }
+  entry.view = view;
+  // The factory is not needed again; free whatever it captured.
+  entry.factory = nullptr;
+  entry.creationTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  const auto ns = static_cast<std::uint64_t>(entry.creationTime.count());
+  created.add();
+  latency.record(ns);
+  metrics::histogram("layout.view_create_ns." + entry.id).record(ns);
+  TB_LOG_DEBUG(Layout, "Created view {} in {} us", entry.id, ns / 1000);
+  return true;
+}
+
+TULayoutView *ViewRegistry::raise(ViewHandle handle, TULayoutFrame *frame) {
+  if (!entry(handle)) return nullptr;
+  auto &found = m_entries[handle.index - 1];
+  if (found.failed || (!found.view && !create(found))) return nullptr;
+  auto lm = PLUG_Services::getLayoutManager();
+  if (!lm) return nullptr;
+  TB_TRACE_SCOPE("layout", "raiseArea");
+  const auto &name = found.options.raiseName.isEmpty() ? found.displayName
+                                                       : found.options.raiseName;
+  lm->raiseArea(name, frame, true, found.options.position);
+  return found.view;
+}
+
+} // namespace util::layout
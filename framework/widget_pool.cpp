@@ -0,0 +1,77 @@
+#include "include/public/toon_boom/ext/layout.hpp"
+
+namespace util::layout {
+
+WidgetPool &WidgetPool::instance() {
+  // Leaked on purpose: deleting pooled widgets during static destruction
+  // would run after Qt has torn down.
+  static WidgetPool *pool = new WidgetPool();
+  return *pool;
+}
+
+void WidgetPool::setBudget(std::size_t bytes) {
+  m_budget = bytes;
+  evictToBudget();
+}
+
+void WidgetPool::release(const std::string &key, QWidget *widget,
+                         std::size_t cost) {
+  if (!widget) return;
+  static auto &released = metrics::counter("layout.pool_released");
+  released.add();
+  if (cost > m_budget) {
+    widget->deleteLater();
+    return;
+  }
+  widget->hide();
+  m_entries.push_front({key, widget, cost});
+  m_used += cost;
+  evictToBudget();
+}
+
+QWidget *WidgetPool::acquire(const std::string &key) {
+  static auto &pooled = metrics::gauge("layout.pool_bytes");
+  for (auto it = m_entries.begin(); it != m_entries.end();) {
+    if (!it->widget) {
+      // Deleted behind our back, e.g. by QApplication teardown.
+      m_used -= it->cost;
+      it = m_entries.erase(it);
+      continue;
+    }
+    if (it->key == key) {
+      QWidget *widget = it->widget.data();
+      m_used -= it->cost;
+      m_entries.erase(it);
+      pooled.set(static_cast<std::int64_t>(m_used));
+      return widget;
+    }
+    ++it;
+  }
+  pooled.set(static_cast<std::int64_t>(m_used));
+  return nullptr;
+}
+
+void WidgetPool::clear() {
+  const auto budget = m_budget;
+  setBudget(0);
+  m_budget = budget;
+}
+
+void WidgetPool::evictToBudget() {
+  static auto &evicted = metrics::counter("layout.pool_evicted");
+  while (m_used > m_budget && !m_entries.empty()) {
+    auto &entry = m_entries.back();
+    if (entry.widget) {
+      TB_LOG_DEBUG(Layout, "Evicting pooled widget {} ({} bytes)", entry.key,
+                   entry.cost);
+      entry.widget->deleteLater();
+      evicted.add();
+    }
+    m_used -= entry.cost;
+    m_entries.pop_back();
+  }
+  static auto &pooled = metrics::gauge("layout.pool_bytes");
+  pooled.set(static_cast<std::int64_t>(m_used));
+}
+
+} // namespace util::layout
@@ -0,0 +1,225 @@
+#include "deploy.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char *kDeployRecord = "toon_boom_injector.deployed";
+
+enum class Outcome { Copied, Linked, Skipped, Failed };
+
+struct Result {
+  Outcome outcome = Outcome::Failed;
+  uint64_t bytes = 0;
+  std::string message;
+};
+
+// Both files are read in full either way, so compare bytes rather than
+// hashes that could collide. The caller has checked the sizes match.
+bool sameContent(const fs::path &a, const fs::path &b) {
+  std::ifstream inA(a, std::ios::binary);
+  std::ifstream inB(b, std::ios::binary);
+  if (!inA || !inB) return false;
+  std::vector<char> bufferA(1 << 20);
+  std::vector<char> bufferB(bufferA.size());
+  for (;;) {
+    inA.read(bufferA.data(), static_cast<std::streamsize>(bufferA.size()));
+    inB.read(bufferB.data(), static_cast<std::streamsize>(bufferB.size()));
+    if (inA.bad() || inB.bad() || inA.gcount() != inB.gcount()) return false;
+    auto got = static_cast<size_t>(inA.gcount());
+    if (!std::equal(bufferA.begin(), bufferA.begin() + got, bufferB.begin())) {
+      return false;
+    }
+    if (!inA || !inB) return !inA && !inB;
+  }
+}
+
+// Writes source to a temporary name beside target and renames it into place.
+Result stage(const fs::path &source, const fs::path &target, uint64_t size,
+             bool allowLinks) {
+  Result result;
+  result.bytes = size;
+  auto staged = target;
+  staged += ".tbdeploy.tmp";
+  std::error_code ec;
+  fs::remove(staged, ec);
+
+  bool linked = false;
+  if (allowLinks) {
+    fs::create_hard_link(source, staged, ec);
+    linked = !ec;
+  }
+  if (!linked) {
+    if (!fs::copy_file(source, staged, fs::copy_options::overwrite_existing, ec)) {
+      result.message = "copy failed: " + ec.message();
+      fs::remove(staged, ec);
+      return result;
+    }
+    // Not every platform's copy keeps the mtime, and the next deploy relies
+    // on it to skip hashing.
+    auto sourceTime = fs::last_write_time(source, ec);
+    if (!ec) fs::last_write_time(staged, sourceTime, ec);
+  }
+
+  fs::rename(staged, target, ec);
+  if (ec) {
+    result.message = "could not replace target (is the program running?): " +
+                     ec.message();
+    fs::remove(staged, ec);
+    return result;
+  }
+  result.outcome = linked ? Outcome::Linked : Outcome::Copied;
+  return result;
+}
+
+Result deployOne(const fs::path &source, const fs::path &target,
+                 const DeployOptions &options) {
+  Result result;
+  std::error_code ec;
+  auto size = fs::file_size(source, ec);
+  if (ec) {
+    result.message = "cannot read source: " + ec.message();
+    return result;
+  }
+  auto sourceTime = fs::last_write_time(source, ec);
+  if (ec) {
+    result.message = "cannot read source: " + ec.message();
+    return result;
+  }
+
+  std::error_code targetEc;
+  auto targetSize = fs::file_size(target, targetEc);
+  if (!targetEc && targetSize == size) {
+    auto targetTime = fs::last_write_time(target, targetEc);
+    if (!targetEc && targetTime == sourceTime) {
+      return {Outcome::Skipped, size, {}};
+    }
+    if (!targetEc && sameContent(source, target)) {
+      // Align the mtime so the next run takes the cheap path.
+      fs::last_write_time(target, sourceTime, ec);
+      return {Outcome::Skipped, size, {}};
+    }
+  }
+  return stage(source, target, size, options.allowLinks);
+}
+
+// Adds names to the record, replacing it the same way stage() replaces a
+// dll.
+void recordDeployed(const fs::path &targetDir,
+                    const std::vector<std::string> &names) {
+  auto all = deployedNames(targetDir);
+  std::set<std::string> known(all.begin(), all.end());
+  bool changed = false;
+  for (const auto &name : names) {
+    if (known.insert(name).second) {
+      all.push_back(name);
+      changed = true;
+    }
+  }
+  if (!changed) return;
+  auto record = targetDir / kDeployRecord;
+  auto staged = record;
+  staged += ".tbdeploy.tmp";
+  {
+    std::ofstream out(staged, std::ios::trunc);
+    for (const auto &name : all) out << name << '\n';
+    if (!out) {
+      std::cerr << "[warning] could not write " << record << std::endl;
+      return;
+    }
+  }
+  std::error_code ec;
+  fs::rename(staged, record, ec);
+  if (ec) {
+    std::cerr << "[warning] could not write " << record << ": " << ec.message()
+              << std::endl;
+    fs::remove(staged, ec);
+  }
+}
+
+} // namespace
+
+std::string formatBytes(uint64_t bytes) {
+  const char *units[] = {"B", "KiB", "MiB", "GiB"};
+  double value = static_cast<double>(bytes);
+  int unit = 0;
+  while (value >= 1024.0 && unit < 3) {
+    value /= 1024.0;
+    unit++;
+  }
+  char text[32];
+  std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.1f %s", value,
+                units[unit]);
+  return text;
+}
+
+std::vector<std::string> deployedNames(const fs::path &targetDir) {
+  std::vector<std::string> names;
+  std::ifstream in(targetDir / kDeployRecord);
+  for (std::string line; std::getline(in, line);) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (!line.empty()) names.push_back(line);
+  }
+  return names;
+}
+
+DeploySummary deployFiles(const std::vector<DeployItem> &items,
+                          const fs::path &targetDir,
+                          const DeployOptions &options) {
+  std::vector<const DeployItem *> unique;
+  {
+    std::set<fs::path> names;
+    for (const auto &item : items) {
+      if (names.insert(item.source.filename()).second) unique.push_back(&item);
+    }
+  }
+
+  std::vector<Result> results(unique.size());
+  parallelForEach(unique.size(), options.workers, [&](size_t i) {
+    const auto &source = unique[i]->source;
+    results[i] = deployOne(source, targetDir / source.filename(), options);
+  });
+
+  DeploySummary summary;
+  std::vector<std::string> deployed;
+  for (size_t i = 0; i < unique.size(); i++) {
+    const auto &item = *unique[i];
+    const auto &result = results[i];
+    const char *what = item.isDep ? "dependency dll" : "dll";
+    switch (result.outcome) {
+    case Outcome::Copied:
+      summary.copiedFiles++;
+      summary.copiedBytes += result.bytes;
+      break;
+    case Outcome::Linked:
+      summary.linkedFiles++;
+      summary.linkedBytes += result.bytes;
+      break;
+    case Outcome::Skipped:
+      summary.skippedFiles++;
+      summary.skippedBytes += result.bytes;
+      break;
+    case Outcome::Failed:
+      summary.failedFiles++;
+      std::cerr << "[warning] could not deploy " << what << " " << item.source
+                << ": " << result.message << std::endl;
+      continue;
+    }
+    deployed.push_back(item.source.filename().string());
+    if (options.verbose) {
+      const char *verb = result.outcome == Outcome::Copied   ? "Copied"
+                         : result.outcome == Outcome::Linked ? "Linked"
+                                                             : "Unchanged";
+      std::cout << verb << " " << what << " " << item.source << " -> "
+                << targetDir / item.source.filename() << std::endl;
+    }
+  }
+  recordDeployed(targetDir, deployed);
+  return summary;
+}
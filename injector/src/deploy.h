@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct DeployItem {
+  std::filesystem::path source;
+  // Dependencies are only reported differently; they deploy the same way.
+  bool isDep = false;
+};
+
+struct DeployOptions {
+  // Hardlink instead of copying when source and target share a volume. The
+  // source then stays locked while the program runs, so rebuilding it in
+  // place fails until the program exits.
+  bool allowLinks = false;
+  bool verbose = false;
+  // 0 picks the hardware thread count.
+  unsigned workers = 0;
+};
+
+struct DeploySummary {
+  size_t copiedFiles = 0;
+  uint64_t copiedBytes = 0;
+  size_t linkedFiles = 0;
+  uint64_t linkedBytes = 0;
+  size_t skippedFiles = 0;
+  uint64_t skippedBytes = 0;
+  size_t failedFiles = 0;
+};
+
+// Puts every item into targetDir under its file name, skipping files that
+// are already identical there. Unchanged size and mtime count as identical
+// without reading either file; a size match with a different mtime falls
+// back to comparing contents byte for byte. Each file is written to a temporary
+// name next to its target and renamed over it, so an interrupted deploy
+// never leaves a truncated DLL behind. When two items share a file name the
+// first one wins. The names of deployed files are added to a record in
+// targetDir; see deployedNames().
+DeploySummary deployFiles(const std::vector<DeployItem> &items,
+                          const std::filesystem::path &targetDir,
+                          const DeployOptions &options);
+
+// File names deployFiles() has put into targetDir on this or earlier runs.
+// They tell the injector's own files apart from the ones the program ships.
+std::vector<std::string> deployedNames(const std::filesystem::path &targetDir);
+
+std::string formatBytes(uint64_t bytes);
@@ -0,0 +1,167 @@
+#include "farm.h"
+#include "parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <istream>
+#include <limits>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string trim(const std::string &text) {
+  const char *space = " \t\r";
+  auto begin = text.find_first_not_of(space);
+  if (begin == std::string::npos) return {};
+  auto end = text.find_last_not_of(space);
+  return text.substr(begin, end - begin + 1);
+}
+
+// The whole value must be an integer in [0, max]; std::stoul would take
+// "8x" as 8 and "-1" as ULONG_MAX.
+std::optional<uint64_t> parseNumber(const std::string &text, uint64_t max) {
+  uint64_t value = 0;
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc() || end != text.data() + text.size() || value > max) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+uint64_t availableMemory() {
+#ifdef _WIN32
+  MEMORYSTATUSEX status = {};
+  status.dwLength = sizeof(status);
+  if (!GlobalMemoryStatusEx(&status)) return 0;
+  return status.ullAvailPhys;
+#else
+  long pages = sysconf(_SC_AVPHYS_PAGES);
+  long pageSize = sysconf(_SC_PAGESIZE);
+  if (pages <= 0 || pageSize <= 0) return 0;
+  return static_cast<uint64_t>(pages) * static_cast<uint64_t>(pageSize);
+#endif
+}
+
+} // namespace
+
+std::optional<FarmManifest> parseFarmManifest(std::istream &in,
+                                              const fs::path &baseDir,
+                                              std::string *error) {
+  FarmManifest manifest;
+  FarmJob *job = nullptr;
+  bool inFarm = false;
+  std::string line;
+  int lineNumber = 0;
+  auto fail = [&](const std::string &message) {
+    if (error) *error = "line " + std::to_string(lineNumber) + ": " + message;
+    return std::nullopt;
+  };
+  auto resolve = [&](const std::string &value) {
+    fs::path path(std::u8string(value.begin(), value.end()));
+    return path.is_absolute() ? path : baseDir / path;
+  };
+
+  while (std::getline(in, line)) {
+    lineNumber++;
+    line = trim(line);
+    if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+    if (line.front() == '[') {
+      if (line.back() != ']') return fail("unterminated section header");
+      auto name = trim(line.substr(1, line.size() - 2));
+      if (name.empty()) return fail("empty section name");
+      inFarm = name == "farm";
+      job = nullptr;
+      if (!inFarm) {
+        manifest.jobs.push_back({});
+        job = &manifest.jobs.back();
+        job->name = name;
+      }
+      continue;
+    }
+    auto equals = line.find('=');
+    if (equals == std::string::npos) return fail("expected key = value");
+    auto key = trim(line.substr(0, equals));
+    auto value = trim(line.substr(equals + 1));
+
+    if (inFarm) {
+      if (key == "concurrency") {
+        auto number = parseNumber(value, std::numeric_limits<unsigned>::max());
+        if (!number) return fail("'" + key + "' expects a number");
+        manifest.concurrency = static_cast<unsigned>(*number);
+      } else if (key == "memory-per-job-mb") {
+        auto number = parseNumber(value, std::numeric_limits<uint64_t>::max() >> 20);
+        if (!number) return fail("'" + key + "' expects a number");
+        manifest.memoryPerJob = *number << 20;
+      } else if (key == "dep-dir") {
+        manifest.depDirs.push_back(resolve(value));
+      } else {
+        return fail("unknown farm key '" + key + "'");
+      }
+    } else if (job) {
+      if (key == "program") {
+        job->program = resolve(value);
+      } else if (key == "args") {
+        job->args = value;
+      } else if (key == "dll") {
+        job->dlls.push_back(resolve(value));
+      } else if (key == "dep") {
+        job->deps.push_back(resolve(value));
+      } else if (key == "log") {
+        job->logFile = resolve(value);
+      } else {
+        return fail("unknown job key '" + key + "'");
+      }
+    } else {
+      return fail("key outside of a section");
+    }
+  }
+
+  for (const auto &parsed : manifest.jobs) {
+    if (parsed.program.empty()) {
+      if (error) *error = "job '" + parsed.name + "' has no program";
+      return std::nullopt;
+    }
+  }
+  return manifest;
+}
+
+unsigned defaultFarmConcurrency(uint64_t memoryPerJob) {
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  uint64_t memory = availableMemory();
+  if (memory == 0 || memoryPerJob == 0) return cores;
+  auto byMemory = static_cast<unsigned>(
+      std::min<uint64_t>(memory / memoryPerJob, cores));
+  return std::max(1u, byMemory);
+}
+
+std::vector<FarmResult>
+runFarm(const std::vector<FarmJob> &jobs, ProcessLauncher &launcher,
+        unsigned concurrency,
+        const std::function<void(const FarmResult &)> &onFinished) {
+  std::vector<FarmResult> results(jobs.size());
+  std::mutex reportMutex;
+  parallelForEach(jobs.size(), std::max(1u, concurrency), [&](size_t i) {
+    auto &result = results[i];
+    result.name = jobs[i].name;
+    auto start = std::chrono::steady_clock::now();
+    try {
+      result.exitCode = launcher.run(jobs[i], result.error);
+    } catch (const std::exception &e) {
+      result.error = e.what();
+    }
+    result.wallTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (onFinished) {
+      std::lock_guard lock(reportMutex);
+      onFinished(result);
+    }
+  });
+  return results;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct FarmJob {
+  std::string name;
+  std::filesystem::path program;
+  // UTF-8; appended to the quoted program path to form the command line.
+  std::string args;
+  std::vector<std::filesystem::path> dlls;
+  std::vector<std::filesystem::path> deps;
+  // Receives the job's stdout and stderr; empty discards them.
+  std::filesystem::path logFile;
+};
+
+struct FarmManifest {
+  std::vector<FarmJob> jobs;
+  std::vector<std::filesystem::path> depDirs;
+  // 0 means size the pool from cores and memory.
+  unsigned concurrency = 0;
+  uint64_t memoryPerJob = 2ull << 30;
+};
+
+// INI manifest. An optional [farm] section sets shared options; every other
+// section is one job named after the section:
+//
+//   [farm]
+//   concurrency = 8
+//   memory-per-job-mb = 3072
+//   dep-dir = D:\deps
+//
+//   [shot_010]
+//   program = C:\Program Files\Toon Boom Animation\...\HarmonyPremium.exe
+//   args = -batch -scene D:\shots\010\010.xstage
+//   dll = D:\build\ext.dll
+//   dep = D:\build\extra.dll
+//   log = D:\logs\010.log
+//
+// dll, dep and dep-dir may repeat. Relative paths resolve against baseDir.
+// Lines starting with ';' or '#' are comments. The manifest is read as UTF-8.
+std::optional<FarmManifest> parseFarmManifest(std::istream &in,
+                                              const std::filesystem::path &baseDir,
+                                              std::string *error = nullptr);
+
+class ProcessLauncher {
+public:
+  virtual ~ProcessLauncher() = default;
+  // Starts the job, injects its dlls, waits for it to exit and returns its
+  // exit code. Called concurrently from several threads. Returns nullopt
+  // and sets error if the job could not be started or injected.
+  virtual std::optional<int> run(const FarmJob &job, std::string &error) = 0;
+};
+
+struct FarmResult {
+  std::string name;
+  std::optional<int> exitCode;
+  std::string error;
+  std::chrono::milliseconds wallTime{0};
+};
+
+// min(hardware threads, available memory / memoryPerJob), at least 1.
+unsigned defaultFarmConcurrency(uint64_t memoryPerJob);
+
+// Runs every job with at most `concurrency` running at once, in manifest
+// order as slots free up. onFinished, if set, is called once per job as it
+// ends, never concurrently with itself. Results are in manifest order.
+std::vector<FarmResult>
+runFarm(const std::vector<FarmJob> &jobs, ProcessLauncher &launcher,
+        unsigned concurrency,
+        const std::function<void(const FarmResult &)> &onFinished = {});
@@ -1,57 +1,262 @@
 #include "finder.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <sstream>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+using VersionList = std::vector<std::pair<std::string, fs::directory_entry>>;
+
+constexpr const char *kCacheHeader = "toon-boom-installs 2";
+
+const std::set<std::string> &exeNames() {
+  static const std::set<std::string> names = {
+      "StoryboardPro.exe", "HarmonyPremium.exe", "HarmonyAdvanced.exe",
+      "HarmonyEssentials.exe"};
+  return names;
+}
+
+// 0 for anything that cannot be stat'ed, so a root that appears later
+// invalidates the cache.
+long long mtimeOf(const fs::path &path) {
+  std::error_code ec;
+  auto time = fs::last_write_time(path, ec);
+  if (ec) return 0;
+  return static_cast<long long>(time.time_since_epoch().count());
+}
+
+std::string lowercase(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return text;
+}
+
+std::vector<fs::path> productDirs(const fs::path &root) {
+  std::vector<fs::path> dirs;
+  std::error_code ec;
+  for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+    if (it->is_directory(ec) &&
+        it->path().filename().string().find("Toon Boom") != std::string::npos) {
+      dirs.push_back(it->path());
+    }
+  }
+  std::sort(dirs.begin(), dirs.end());
+  return dirs;
+}
+
+// The pruned names, comma-separated, for comparing a cache's settings.
+std::string prunedList(const FinderOptions &options) {
+  std::string list;
+  for (const auto &name : options.prunedDirs) {
+    list += (list.empty() ? "" : ",") + name;
+  }
+  return list;
+}
+
+struct CacheIndex {
+  int maxDepth = -1;
+  std::string prunedDirs;
+  std::vector<std::pair<fs::path, long long>> roots;
+  std::vector<std::pair<fs::path, long long>> products;
+  std::vector<std::pair<std::string, fs::path>> exes;
+};
+
+// Lines are tab-separated: "settings <max depth> <pruned list>",
+// "root|product <mtime> <path>" or "exe <product name> <path>".
+bool readCache(const fs::path &cachePath, CacheIndex &index) {
+  std::ifstream in(cachePath);
+  std::string line;
+  if (!in || !std::getline(in, line) || line != kCacheHeader) return false;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string kind, first, path;
+    if (!std::getline(fields, kind, '\t') || !std::getline(fields, first, '\t')) {
+      return false;
+    }
+    // Only the pruned list may be empty.
+    if (!std::getline(fields, path) && kind != "settings") return false;
+    try {
+      if (kind == "settings") {
+        index.maxDepth = std::stoi(first);
+        index.prunedDirs = path;
+      } else if (kind == "root") {
+        index.roots.emplace_back(path, std::stoll(first));
+      } else if (kind == "product") {
+        index.products.emplace_back(path, std::stoll(first));
+      } else if (kind == "exe") {
+        index.exes.emplace_back(first, path);
+      } else {
+        return false;
+      }
+    } catch (const std::exception &) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool cacheIsValid(const CacheIndex &index, const FinderOptions &options) {
+  // Results found with other settings may include or miss executables.
+  if (index.maxDepth != options.maxDepth || index.prunedDirs != prunedList(options)) {
+    return false;
+  }
+  if (index.roots.size() != options.roots.size()) return false;
+  for (size_t i = 0; i < options.roots.size(); i++) {
+    if (index.roots[i].first != options.roots[i] ||
+        index.roots[i].second != mtimeOf(options.roots[i])) {
+      return false;
+    }
+  }
+  for (const auto &[path, mtime] : index.products) {
+    if (mtimeOf(path) != mtime) return false;
+  }
+  // Executables sit below the product directory, so their mtime does not
+  // bubble up; check they are still there.
+  std::error_code ec;
+  for (const auto &[name, path] : index.exes) {
+    if (!fs::is_regular_file(path, ec)) return false;
+  }
+  return true;
+}
+
+void writeCache(const fs::path &cachePath, const FinderOptions &options,
+                const std::vector<fs::path> &products, const VersionList &versions) {
+  std::error_code ec;
+  fs::create_directories(cachePath.parent_path(), ec);
+  auto tmp = cachePath;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    if (!out) return;
+    out << kCacheHeader << '\n';
+    out << "settings\t" << options.maxDepth << '\t' << prunedList(options) << '\n';
+    for (const auto &root : options.roots) {
+      out << "root\t" << mtimeOf(root) << '\t' << root.string() << '\n';
+    }
+    for (const auto &product : products) {
+      out << "product\t" << mtimeOf(product) << '\t' << product.string() << '\n';
+    }
+    for (const auto &[name, entry] : versions) {
+      out << "exe\t" << name << '\t' << entry.path().string() << '\n';
+    }
+  }
+  fs::rename(tmp, cachePath, ec);
+}
+
+} // namespace
+
+std::vector<fs::path> defaultToonBoomRoots() {
+  return {"C:\\Program Files\\Toon Boom Animation\\",
+          "C:\\Program Files (x86)\\Toon Boom Animation\\"};
+}
+
+fs::path defaultFinderCachePath() {
+#ifdef _WIN32
+  char base[MAX_PATH] = {};
+  DWORD n = GetEnvironmentVariableA("LOCALAPPDATA", base, MAX_PATH);
+  if (n == 0 || n >= MAX_PATH) return {};
+  return fs::path(base) / "toon-boom-extension-framework" / "installs.idx";
+#else
+  const char *base = std::getenv("XDG_CACHE_HOME");
+  if (base && *base) return fs::path(base) / "toon-boom-extension-framework" / "installs.idx";
+  const char *home = std::getenv("HOME");
+  if (!home || !*home) return {};
+  return fs::path(home) / ".cache" / "toon-boom-extension-framework" / "installs.idx";
+#endif
+}
+
 std::vector<std::pair<std::string, std::filesystem::directory_entry>> findToonBoomVersions() {
-  std::string programFiles("C:\\Program Files\\Toon Boom Animation\\");
-  std::string programFilesX86("C:\\Program Files (x86)\\Toon Boom Animation\\");
+  FinderOptions options;
+  options.roots = defaultToonBoomRoots();
+  options.cachePath = defaultFinderCachePath();
+  return findToonBoomVersions(options);
+}
 
-  std::vector<std::pair<std::string, std::filesystem::directory_entry>> versions;
-  try {
-    for (const auto &entry : fs::directory_iterator(programFiles)) {
-      auto subEntries = findSubEntries(entry);
-      versions.insert(versions.end(), subEntries.begin(), subEntries.end());
+std::vector<std::pair<std::string, std::filesystem::directory_entry>>
+findToonBoomVersions(const FinderOptions &options) {
+  if (!options.cachePath.empty()) {
+    CacheIndex index;
+    if (readCache(options.cachePath, index) && cacheIsValid(index, options)) {
+      VersionList versions;
+      for (const auto &[name, path] : index.exes) {
+        versions.emplace_back(name, fs::directory_entry(path));
+      }
+      return versions;
     }
-  } catch (const std::filesystem::filesystem_error &e) {
   }
-  try {
-    for (const auto &entry : fs::directory_iterator(programFilesX86)) {
-      auto subEntries = findSubEntries(entry);
+
+  std::vector<fs::path> products;
+  for (const auto &root : options.roots) {
+    auto dirs = productDirs(root);
+    products.insert(products.end(), dirs.begin(), dirs.end());
+  }
+
+  // One walk per product; there are only ever a handful, and each is
+  // dominated by directory I/O.
+  std::vector<std::future<VersionList>> walks;
+  walks.reserve(products.size());
+  for (const auto &product : products) {
+    walks.push_back(std::async(std::launch::async, [&options, product]() {
+      return findSubEntries(fs::directory_entry(product), options);
+    }));
+  }
+  VersionList versions;
+  for (auto &walk : walks) {
+    try {
+      auto subEntries = walk.get();
       versions.insert(versions.end(), subEntries.begin(), subEntries.end());
+    } catch (const std::filesystem::filesystem_error &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
     }
-  } catch (const std::filesystem::filesystem_error &e) {
-    std::cerr << "Error: " << e.what() << std::endl;
   }
 
+  if (!options.cachePath.empty()) {
+    writeCache(options.cachePath, options, products, versions);
+  }
   return versions;
 }
 
 std::vector<std::pair<std::string, std::filesystem::directory_entry>>
 findSubEntries(const std::filesystem::directory_entry &entry) {
+  return findSubEntries(entry, FinderOptions());
+}
+
+std::vector<std::pair<std::string, std::filesystem::directory_entry>>
+findSubEntries(const std::filesystem::directory_entry &entry, const FinderOptions &options) {
   std::vector<std::pair<std::string, std::filesystem::directory_entry>> versions;
-  std::set<std::string> exeNames = {"StoryboardPro.exe", "HarmonyPremium.exe",
-                                    "HarmonyAdvanced.exe",
-                                    "HarmonyEssentials.exe"};
-  if (fs::is_directory(entry.path())) {
-    if (entry.path().filename().string().find("Toon Boom") !=
-        std::string::npos) {
-      for (const auto &subEntry :
-           fs::recursive_directory_iterator(entry.path())) {
-        try {
-          if (fs::is_regular_file(subEntry.path()) &&
-              exeNames.contains(subEntry.path().filename().string())) {
-            versions.push_back(std::make_pair(entry.path().filename().string(), subEntry));
-          }
-        } catch (const std::filesystem::filesystem_error &e) {
-					continue;
-        }
+  std::error_code ec;
+  if (!entry.is_directory(ec) ||
+      entry.path().filename().string().find("Toon Boom") == std::string::npos) {
+    return versions;
+  }
+  const auto productName = entry.path().filename().string();
+  fs::recursive_directory_iterator it(
+      entry.path(), fs::directory_options::skip_permission_denied, ec);
+  for (fs::recursive_directory_iterator end; !ec && it != end; it.increment(ec)) {
+    const auto &subEntry = *it;
+    std::error_code entryEc;
+    if (subEntry.is_directory(entryEc)) {
+      if (it.depth() + 1 >= options.maxDepth ||
+          options.prunedDirs.contains(lowercase(subEntry.path().filename().string()))) {
+        it.disable_recursion_pending();
       }
+      continue;
+    }
+    if (exeNames().contains(subEntry.path().filename().string()) &&
+        subEntry.is_regular_file(entryEc)) {
+      versions.push_back(std::make_pair(productName, subEntry));
     }
   }
   return versions;
 }
 
+#ifdef _WIN32
 DWORD GetProcessIdByName(const std::string& processName) {
     DWORD pid = 0;
     HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
@@ -70,4 +275,5 @@ DWORD GetProcessIdByName(const std::string& processName) {
 
     CloseHandle(hSnapshot);
     return pid;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
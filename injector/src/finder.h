@@ -1,14 +1,43 @@
 #pragma once
+#ifdef _WIN32
 #include <windows.h>
 #include <TlHelp32.h>
+#endif
 #include <string>
 #include <vector>
 #include <filesystem>
 #include <set>
 
+struct FinderOptions {
+  // Directories whose "Toon Boom*" children are product installs.
+  std::vector<std::filesystem::path> roots;
+  // How far below a product directory to look for executables.
+  int maxDepth = 4;
+  // Directory names (lowercase) that never contain a product executable.
+  std::set<std::string> prunedDirs = {"resources", "help",      "plugins",
+                                      "fonts",     "templates", "translations",
+                                      "examples",  "python"};
+  // Index file reused while every root and product directory keeps its
+  // mtime and maxDepth and prunedDirs are unchanged. Empty disables
+  // caching.
+  std::filesystem::path cachePath;
+};
 
+// `Program Files` and `Program Files (x86)` Toon Boom Animation folders.
+std::vector<std::filesystem::path> defaultToonBoomRoots();
+
+// %LOCALAPPDATA%/toon-boom-extension-framework/installs.idx
+std::filesystem::path defaultFinderCachePath();
+
+// findToonBoomVersions with the default roots and cache.
 std::vector<std::pair<std::string, std::filesystem::directory_entry>> findToonBoomVersions();
 
+std::vector<std::pair<std::string, std::filesystem::directory_entry>> findToonBoomVersions(const FinderOptions& options);
+
 std::vector<std::pair<std::string, std::filesystem::directory_entry>> findSubEntries(const std::filesystem::directory_entry& entry);
 
-DWORD GetProcessIdByName(const std::string& processName);
\ No newline at end of file
+std::vector<std::pair<std::string, std::filesystem::directory_entry>> findSubEntries(const std::filesystem::directory_entry& entry, const FinderOptions& options);
+
+#ifdef _WIN32
+DWORD GetProcessIdByName(const std::string& processName);
+#endif
\ No newline at end of file
@@ -0,0 +1,164 @@
+#ifdef _WIN32
+#include "inject.h"
+
+namespace {
+
+std::wstring fromUtf8(const std::string &text) {
+  if (text.empty()) return {};
+  int length = MultiByteToWideChar(CP_UTF8, 0, text.data(),
+                                   static_cast<int>(text.size()), NULL, 0);
+  std::wstring wide(static_cast<size_t>(length), L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                      wide.data(), length);
+  return wide;
+}
+
+} // namespace
+
+std::optional<std::vector<remote_loader::LoadResult>>
+injectDlls(HANDLE hProcess, const std::vector<std::filesystem::path> &dllPaths,
+           std::string &error) {
+  // kernel32 is mapped at the same address in every process of a boot, so
+  // our own export addresses are valid in the target.
+  HMODULE hKernel32 = GetModuleHandleA("kernel32.dll");
+  std::vector<std::u16string> widePaths;
+  for (const auto &dllPath : dllPaths) {
+    widePaths.push_back(dllPath.u16string());
+  }
+  auto payload = remote_loader::buildPayload(
+      widePaths,
+      reinterpret_cast<uint64_t>(GetProcAddress(hKernel32, "LoadLibraryW")),
+      reinterpret_cast<uint64_t>(GetProcAddress(hKernel32, "GetLastError")));
+  auto remoteBuffer = static_cast<uint8_t *>(
+      VirtualAllocEx(hProcess, NULL, payload.bytes.size(),
+                     MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+  if (remoteBuffer == NULL) {
+    error = "Failed to allocate memory in target process";
+    return std::nullopt;
+  }
+  DWORD oldProtect;
+  if (!WriteProcessMemory(hProcess, remoteBuffer, payload.bytes.data(),
+                          payload.bytes.size(), NULL) ||
+      !VirtualProtectEx(hProcess, remoteBuffer, remote_loader::kCodeSize,
+                        PAGE_EXECUTE_READ, &oldProtect)) {
+    error = "Failed to write process memory";
+    VirtualFreeEx(hProcess, remoteBuffer, 0, MEM_RELEASE);
+    return std::nullopt;
+  }
+  uint8_t *remoteData = remoteBuffer + payload.dataOffset;
+  HANDLE hThread = CreateRemoteThread(hProcess, NULL, 0,
+                                      (LPTHREAD_START_ROUTINE)remoteBuffer,
+                                      remoteData, 0, NULL);
+  if (hThread == NULL) {
+    error = "Failed to create remote thread";
+    VirtualFreeEx(hProcess, remoteBuffer, 0, MEM_RELEASE);
+    return std::nullopt;
+  }
+  WaitForSingleObject(hThread, INFINITE);
+  CloseHandle(hThread);
+
+  std::vector<uint8_t> data(payload.bytes.size() - payload.dataOffset);
+  bool read = ReadProcessMemory(hProcess, remoteData, data.data(), data.size(),
+                                NULL);
+  VirtualFreeEx(hProcess, remoteBuffer, 0, MEM_RELEASE);
+  if (!read) {
+    error = "Failed to read loader results";
+    return std::nullopt;
+  }
+  return remote_loader::readResults(data.data(), data.size(), dllPaths.size());
+}
+
+std::optional<int> WindowsProcessLauncher::run(const FarmJob &job,
+                                               std::string &error) {
+  SECURITY_ATTRIBUTES sattr;
+  ZeroMemory(&sattr, sizeof(sattr));
+  sattr.nLength = sizeof(sattr);
+  sattr.bInheritHandle = TRUE;
+  HANDLE outHandle = CreateFileW(
+      job.logFile.empty() ? L"NUL" : job.logFile.wstring().c_str(),
+      GENERIC_WRITE, FILE_SHARE_WRITE | FILE_SHARE_READ, &sattr, CREATE_ALWAYS,
+      FILE_ATTRIBUTE_NORMAL, NULL);
+  if (outHandle == INVALID_HANDLE_VALUE) {
+    error = "Failed to create log file (error " +
+            std::to_string(GetLastError()) + ")";
+    return std::nullopt;
+  }
+
+  // Jobs start concurrently, so limit inheritance to this job's log handle;
+  // otherwise every child would hold every other job's log open.
+  SIZE_T attributeSize = 0;
+  InitializeProcThreadAttributeList(NULL, 1, 0, &attributeSize);
+  std::vector<uint8_t> attributeStorage(attributeSize);
+  auto attributes =
+      reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeStorage.data());
+  if (!InitializeProcThreadAttributeList(attributes, 1, 0, &attributeSize) ||
+      !UpdateProcThreadAttribute(attributes, 0,
+                                 PROC_THREAD_ATTRIBUTE_HANDLE_LIST, &outHandle,
+                                 sizeof(outHandle), NULL, NULL)) {
+    error = "Failed to set up process attributes";
+    CloseHandle(outHandle);
+    return std::nullopt;
+  }
+
+  STARTUPINFOEXW si;
+  PROCESS_INFORMATION pi;
+  ZeroMemory(&si, sizeof(si));
+  ZeroMemory(&pi, sizeof(pi));
+  si.StartupInfo.cb = sizeof(si);
+  si.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
+  si.StartupInfo.hStdOutput = outHandle;
+  si.StartupInfo.hStdError = outHandle;
+  si.lpAttributeList = attributes;
+  std::wstring commandLine = L"\"" + job.program.wstring() + L"\"";
+  if (!job.args.empty()) {
+    commandLine += L" " + fromUtf8(job.args);
+  }
+  auto workingDir = job.program.parent_path().wstring();
+  BOOL created = CreateProcessW(
+      NULL, commandLine.data(), NULL, NULL, TRUE,
+      CREATE_SUSPENDED | CREATE_NO_WINDOW | EXTENDED_STARTUPINFO_PRESENT, NULL,
+      workingDir.c_str(), &si.StartupInfo, &pi);
+  DWORD createError = created ? 0 : GetLastError();
+  DeleteProcThreadAttributeList(attributes);
+  if (!created) {
+    error = "Failed to create process (error " + std::to_string(createError) +
+            ")";
+    CloseHandle(outHandle);
+    return std::nullopt;
+  }
+
+  auto abandon = [&](const std::string &message) -> std::optional<int> {
+    error = message;
+    TerminateProcess(pi.hProcess, 1);
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    CloseHandle(outHandle);
+    return std::nullopt;
+  };
+
+  std::vector<std::filesystem::path> dllPaths;
+  for (const auto &dll : job.dlls) {
+    dllPaths.push_back(job.program.parent_path() / dll.filename());
+  }
+  if (!dllPaths.empty()) {
+    std::string injectError;
+    auto results = injectDlls(pi.hProcess, dllPaths, injectError);
+    if (!results) return abandon(injectError);
+    for (size_t i = 0; i < results->size(); i++) {
+      if ((*results)[i].module == 0) {
+        return abandon("Failed to load " + dllPaths[i].filename().string() +
+                       " (error " + std::to_string((*results)[i].error) + ")");
+      }
+    }
+  }
+
+  ResumeThread(pi.hThread);
+  WaitForSingleObject(pi.hProcess, INFINITE);
+  DWORD exitCode = 0;
+  GetExitCodeProcess(pi.hProcess, &exitCode);
+  CloseHandle(pi.hThread);
+  CloseHandle(pi.hProcess);
+  CloseHandle(outHandle);
+  return static_cast<int>(exitCode);
+}
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+#include "farm.h"
+#include "remote_loader.h"
+
+// Loads dllPaths into the process from a single remote thread running the
+// remote_loader stub, and returns one result per path in order. Returns
+// nullopt and sets error if the stub could not be run at all.
+std::optional<std::vector<remote_loader::LoadResult>>
+injectDlls(HANDLE hProcess, const std::vector<std::filesystem::path> &dllPaths,
+           std::string &error);
+
+// Starts each job suspended, injects its dlls from the program's directory,
+// resumes it and waits for it to exit.
+class WindowsProcessLauncher : public ProcessLauncher {
+public:
+  std::optional<int> run(const FarmJob &job, std::string &error) override;
+};
+#endif
@@ -1,6 +1,13 @@
+#include "./deploy.h"
+#include "./farm.h"
 #include "./finder.h"
+#include "./inject.h"
+#include "./pe_imports.h"
+#include "./telemetry_view.h"
 #include <argparse/argparse.hpp>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <vector>
 
 argparse::ArgumentParser *&createProgram(int argc, char *argv[]) {
@@ -11,7 +18,8 @@ argparse::ArgumentParser *&createProgram(int argc, char *argv[]) {
       .help("show help message and exit")
       .implicit_value(true);
   program->add_argument("-v", "--debug")
-      .help("log program's stdout and stderr to the given file")
+      .help("log program's stdout and stderr to the given file (- for the "
+            "console) and show the framework's live log and metrics")
       .default_value("");
   program->add_argument("-p", "--program")
       .help("path to a Toon Boom program")
@@ -22,8 +30,8 @@ argparse::ArgumentParser *&createProgram(int argc, char *argv[]) {
       .default_value<std::vector<std::string>>({})
       .append(); 
   program->add_argument("-I", "--dep-dir")
-      .help("path to a directory of dependencies to copy into program's "
-            "install dir")
+      .help("path to a directory of dependencies; the ones the injected dlls "
+            "import are copied into program's install dir")
       .default_value(std::vector<std::string>({}))
       .append();
   program->add_argument("-D", "--dll-dir")
@@ -34,30 +42,196 @@ argparse::ArgumentParser *&createProgram(int argc, char *argv[]) {
   program->add_argument("-s", "--sleep")
       .help("sleep for the given number of milliseconds before starting the program")
       .default_value("500").nargs(0, 1);
+  program->add_argument("-r", "--root")
+      .help("directory to search for Toon Boom installs (replaces the "
+            "Program Files defaults)")
+      .default_value<std::vector<std::string>>({})
+      .append();
+  program->add_argument("--all-deps")
+      .help("copy every dll in the dependency dirs instead of only those the "
+            "injected dlls import")
+      .implicit_value(true)
+      .default_value(false);
+  program->add_argument("--sequential")
+      .help("inject each dll with its own remote LoadLibraryA thread instead "
+            "of loading them all from one remote thread")
+      .implicit_value(true)
+      .default_value(false);
+  program->add_argument("--farm")
+      .help("run every job in the given manifest instead of one interactive "
+            "launch")
+      .default_value("");
+  program->add_argument("-j", "--jobs")
+      .help("how many farm jobs to run at once (default: sized to cores and "
+            "memory)")
+      .default_value("0");
+  program->add_argument("--link")
+      .help("hardlink dlls into the install dir instead of copying when "
+            "they are on the same volume")
+      .implicit_value(true)
+      .default_value(false);
+  program->add_argument("--rescan")
+      .help("ignore the cached install index and search again")
+      .implicit_value(true)
+      .default_value(false);
 
   return program;
 }
 
-void copyDll(const std::string &dllPath,
-             const std::filesystem::directory_entry &entry, bool isDebug,
-             bool isDep) {
-  auto absPath = std::filesystem::absolute(dllPath);
-  if (!std::filesystem::exists(absPath)) {
-    std::cerr << "[warning] dll path " << absPath << " does not exist"
-              << std::endl;
-    return;
+// Copies the injected dlls and their dependencies into installDir. With
+// allDeps every dll in depDirs is copied; otherwise only the import closure
+// of the injected dlls.
+void deployDlls(const std::vector<std::filesystem::path> &dllPaths,
+                const std::vector<std::filesystem::path> &dllDeps,
+                const std::vector<std::filesystem::path> &depDirs,
+                const std::filesystem::path &installDir, bool allDeps,
+                const DeployOptions &options) {
+  std::vector<DeployItem> items;
+  auto addItem = [&items](const std::filesystem::path &dllPath, bool isDep) {
+    auto absPath = std::filesystem::absolute(dllPath);
+    if (!std::filesystem::exists(absPath)) {
+      std::cerr << "[warning] dll path " << absPath << " does not exist"
+                << std::endl;
+      return;
+    }
+    items.push_back({absPath, isDep});
+  };
+  for (const auto &dllPath : dllPaths) {
+    addItem(dllPath, false);
   }
-  std::filesystem::copy(absPath,
-                        entry.path().parent_path() /
-                            std::filesystem::path(dllPath).filename().string(),
-                        std::filesystem::copy_options::overwrite_existing);
-  if (isDebug) {
-    std::cout << "Copied " << (isDep ? "dependency dll" : "dll") << " at "
-              << absPath << " to "
-              << entry.path().parent_path() /
-                     std::filesystem::path(dllPath).filename().string()
+  for (const auto &dllPath : dllDeps) {
+    addItem(dllPath, true);
+  }
+  if (allDeps) {
+    for (const auto &depDir : depDirs) {
+      for (auto &depEntry : std::filesystem::directory_iterator(
+               std::filesystem::absolute(depDir))) {
+        if (depEntry.is_regular_file() && depEntry.path().extension() == ".dll") {
+          addItem(depEntry.path(), true);
+        }
+      }
+    }
+  } else if (!depDirs.empty()) {
+    // Only what the injected dlls actually load, minus anything the
+    // program or Windows already ships. Dlls an earlier run deployed into
+    // the install dir are the injector's, not the program's, and are
+    // resolved from the dependency dirs again so changes reach the target.
+    std::vector<std::filesystem::path> roots;
+    for (const auto &item : items) {
+      roots.push_back(item.source);
+    }
+    std::vector<std::filesystem::path> searchDirs;
+    for (const auto &depDir : depDirs) {
+      searchDirs.push_back(std::filesystem::absolute(depDir));
+    }
+    std::vector<std::filesystem::path> providedDirs = {installDir};
+    char systemDir[MAX_PATH];
+    UINT systemDirLength = GetSystemDirectoryA(systemDir, MAX_PATH);
+    if (systemDirLength > 0 && systemDirLength < MAX_PATH) {
+      providedDirs.push_back(systemDir);
+    }
+    auto closure = computeDependencyClosure(roots, searchDirs, providedDirs,
+                                            deployedNames(installDir));
+    for (const auto &[path, error] : closure.unreadable) {
+      std::cerr << "[warning] could not read imports of " << path << ": "
+                << error << std::endl;
+    }
+    for (const auto &name : closure.missing) {
+      std::cerr << "[warning] " << name
+                << " is imported but was not found in any dependency dir"
+                << std::endl;
+    }
+    for (const auto &path : closure.files) {
+      addItem(path, true);
+    }
+  }
+  auto summary = deployFiles(items, installDir, options);
+  std::cout << "Deployed dlls: " << summary.copiedFiles << " copied ("
+            << formatBytes(summary.copiedBytes) << "), "
+            << summary.linkedFiles << " linked ("
+            << formatBytes(summary.linkedBytes) << "), "
+            << summary.skippedFiles << " unchanged ("
+            << formatBytes(summary.skippedBytes) << " skipped)";
+  if (summary.failedFiles > 0) {
+    std::cout << ", " << summary.failedFiles << " failed";
+  }
+  std::cout << std::endl;
+}
+
+int runFarmMode(argparse::ArgumentParser *args) {
+  auto manifestPath = std::filesystem::absolute(args->get<std::string>("--farm"));
+  std::ifstream manifestFile(manifestPath);
+  if (!manifestFile) {
+    std::cerr << "Error: cannot open farm manifest " << manifestPath
               << std::endl;
+    return 1;
+  }
+  std::string error;
+  auto manifest =
+      parseFarmManifest(manifestFile, manifestPath.parent_path(), &error);
+  if (!manifest) {
+    std::cerr << "Error: " << manifestPath << ": " << error << std::endl;
+    return 1;
+  }
+
+  // Deploy once per install dir with the union of every job's dlls, so jobs
+  // sharing a program never race on the same files.
+  std::map<std::filesystem::path, std::pair<std::vector<std::filesystem::path>,
+                                            std::vector<std::filesystem::path>>>
+      installs;
+  for (const auto &job : manifest->jobs) {
+    auto &[dlls, deps] = installs[job.program.parent_path()];
+    dlls.insert(dlls.end(), job.dlls.begin(), job.dlls.end());
+    deps.insert(deps.end(), job.deps.begin(), job.deps.end());
+  }
+  auto depDirs = manifest->depDirs;
+  for (auto depDir : args->get<std::vector<std::string>>("-D")) {
+    depDirs.push_back(depDir);
+  }
+  for (auto depDir : args->get<std::vector<std::string>>("-I")) {
+    depDirs.push_back(depDir);
+  }
+  DeployOptions deployOptions;
+  deployOptions.allowLinks = args->get<bool>("--link");
+  for (const auto &[installDir, files] : installs) {
+    std::cout << "Deploying to " << installDir << std::endl;
+    deployDlls(files.first, files.second, depDirs, installDir,
+               args->get<bool>("--all-deps"), deployOptions);
+  }
+
+  unsigned concurrency = 0;
+  try {
+    concurrency = static_cast<unsigned>(std::stoul(args->get<std::string>("-j")));
+  } catch (const std::exception &e) {
+    std::cerr << "Error: --jobs: " << e.what() << std::endl;
+    return 1;
   }
+  if (concurrency == 0) concurrency = manifest->concurrency;
+  if (concurrency == 0) {
+    concurrency = defaultFarmConcurrency(manifest->memoryPerJob);
+  }
+  std::cout << "Running " << manifest->jobs.size() << " jobs, " << concurrency
+            << " at a time" << std::endl;
+
+  WindowsProcessLauncher launcher;
+  auto results = runFarm(manifest->jobs, launcher, concurrency,
+                         [](const FarmResult &result) {
+                           std::cout << "[" << result.name << "] ";
+                           if (result.exitCode) {
+                             std::cout << "exited with " << *result.exitCode;
+                           } else {
+                             std::cout << "failed: " << result.error;
+                           }
+                           std::cout << " after " << result.wallTime.count()
+                                     << " ms" << std::endl;
+                         });
+  size_t failed = 0;
+  for (const auto &result : results) {
+    if (!result.exitCode || *result.exitCode != 0) failed++;
+  }
+  std::cout << results.size() - failed << " of " << results.size()
+            << " jobs succeeded" << std::endl;
+  return failed == 0 ? 0 : 1;
 }
 
 int main(int argc, char *argv[]) {
@@ -73,6 +247,9 @@ int main(int argc, char *argv[]) {
     std::cout << args->help().str() << std::endl;
     return 0;
   }
+  if (args->get<std::string>("--farm") != "") {
+    return runFarmMode(args);
+  }
 
   bool isDebug = false;
   std::string logFile = "";
@@ -89,8 +266,20 @@ int main(int argc, char *argv[]) {
 
   std::string program = args->get<std::string>("-p");
   if (program == "" || !std::filesystem::exists(program)) {
+    FinderOptions finderOptions;
+    for (const auto &root : args->get<std::vector<std::string>>("-r")) {
+      finderOptions.roots.push_back(root);
+    }
+    if (finderOptions.roots.empty()) {
+      finderOptions.roots = defaultToonBoomRoots();
+    }
+    finderOptions.cachePath = defaultFinderCachePath();
+    if (args->get<bool>("--rescan")) {
+      std::error_code ec;
+      std::filesystem::remove(finderOptions.cachePath, ec);
+    }
     std::vector<std::pair<std::string, std::filesystem::directory_entry>>
-        versions = findToonBoomVersions();
+        versions = findToonBoomVersions(finderOptions);
     bool isValidOption = false;
     std::cout
         << "The following Toon Boom software was detected on your system: "
@@ -123,24 +312,19 @@ int main(int argc, char *argv[]) {
   }
 
   auto dllDeps = args->get<std::vector<std::string>>("-i");
-  for (auto dllPath : dllPaths) {
-    copyDll(dllPath, entry, isDebug, false);
-  }
-  for (auto dllPath : dllDeps) {
-    copyDll(dllPath, entry, isDebug, true);
-  }
   auto depDirs = args->get<std::vector<std::string>>("-D");
+  for (auto depDir : args->get<std::vector<std::string>>("-I")) {
+    depDirs.push_back(depDir);
+  }
   {
-    std::set<std::string> copiedDlls;
-    copiedDlls.insert(dllPaths.begin(), dllPaths.end());
-    for (auto depDir : depDirs) {
-      for (auto &entry : std::filesystem::directory_iterator(
-               std::filesystem::absolute(depDir))) {
-        if (entry.is_regular_file() && entry.path().extension() == ".dll" && !copiedDlls.contains(entry.path().string())) {
-          copyDll(entry.path().string(), entry, isDebug, true);
-        }
-      }
-    }
+    std::vector<std::filesystem::path> dlls(dllPaths.begin(), dllPaths.end());
+    std::vector<std::filesystem::path> deps(dllDeps.begin(), dllDeps.end());
+    std::vector<std::filesystem::path> dirs(depDirs.begin(), depDirs.end());
+    DeployOptions deployOptions;
+    deployOptions.allowLinks = args->get<bool>("--link");
+    deployOptions.verbose = isDebug;
+    deployDlls(dlls, deps, dirs, entry.path().parent_path(),
+               args->get<bool>("--all-deps"), deployOptions);
   }
 
   STARTUPINFO si;
@@ -177,6 +361,13 @@ int main(int argc, char *argv[]) {
   si.hStdError = outHandle;
   si.hStdInput = NULL;
 
+  if (logFile != "") {
+    // Inherited by the target; tells the framework to open its telemetry
+    // ring for us to render. With -v - we render into the console the
+    // program writes to, so it should stop echoing its log there; a log
+    // file keeps getting every line.
+    SetEnvironmentVariableA("TB_EXT_TELEMETRY", logFile == "-" ? "console" : "1");
+  }
   if (!CreateProcess(NULL, entry.path().string().data(), &sattr, NULL, TRUE,
                      CREATE_SUSPENDED, NULL,
                      entry.path().parent_path().string().data(), &si, &pi)) {
@@ -195,48 +386,80 @@ int main(int argc, char *argv[]) {
   HANDLE hProcess = OpenProcess(PROCESS_ALL_ACCESS, FALSE, pi.dwProcessId);
 
   HMODULE hKernel32 = GetModuleHandleA("kernel32.dll");
-  FARPROC hLoadLibraryA = GetProcAddress(hKernel32, "LoadLibraryA");
-  for (auto dllPath : dllPaths) {
-    auto realPath =
-        (std::filesystem::path(program).parent_path().string() + "/" +
-         std::filesystem::absolute(dllPath).filename().string());
-
-    LPVOID remoteBuffer =
-        VirtualAllocEx(hProcess, NULL, dllPath.size() + 1,
-                       MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-    if (remoteBuffer == NULL) {
-      std::cerr << "Failed to allocate memory in target process" << std::endl;
-      return 1;
+  if (!args->get<bool>("--sequential")) {
+    std::vector<std::filesystem::path> remotePaths;
+    for (auto dllPath : dllPaths) {
+      remotePaths.push_back(entry.path().parent_path() /
+                            std::filesystem::absolute(dllPath).filename());
     }
-    if (!WriteProcessMemory(hProcess, remoteBuffer, realPath.data(),
-                            realPath.size() + 1, NULL)) {
-      std::cerr << "Failed to write process memory" << std::endl;
+    std::string injectError;
+    auto results = injectDlls(hProcess, remotePaths, injectError);
+    if (!results) {
+      std::cerr << injectError << std::endl;
       CloseHandle(hProcess);
       CloseHandle(outHandle);
       return 1;
     }
-    DWORD remoteTID;
-    HANDLE hThread = CreateRemoteThread(hProcess, NULL, 0,
-                                        (LPTHREAD_START_ROUTINE)hLoadLibraryA,
-                                        remoteBuffer, 0, &remoteTID);
-    if (hThread == NULL) {
-      std::cerr << "Failed to create remote thread" << std::endl;
+    size_t loaded = 0;
+    for (size_t i = 0; i < results->size(); i++) {
+      if ((*results)[i].module == 0) {
+        std::cerr << "Failed to load " << dllPaths[i] << " (error "
+                  << (*results)[i].error << ")" << std::endl;
+      } else {
+        loaded++;
+      }
+    }
+    std::cout << "Loaded " << loaded << " of " << dllPaths.size() << " dlls"
+              << std::endl;
+  } else {
+    FARPROC hLoadLibraryA = GetProcAddress(hKernel32, "LoadLibraryA");
+    for (auto dllPath : dllPaths) {
+      auto realPath = (entry.path().parent_path() /
+                       std::filesystem::absolute(dllPath).filename())
+                          .string();
+
+      LPVOID remoteBuffer =
+          VirtualAllocEx(hProcess, NULL, realPath.size() + 1,
+                         MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+      if (remoteBuffer == NULL) {
+        std::cerr << "Failed to allocate memory in target process" << std::endl;
+        return 1;
+      }
+      if (!WriteProcessMemory(hProcess, remoteBuffer, realPath.data(),
+                              realPath.size() + 1, NULL)) {
+        std::cerr << "Failed to write process memory" << std::endl;
+        CloseHandle(hProcess);
+        CloseHandle(outHandle);
+        return 1;
+      }
+      DWORD remoteTID;
+      HANDLE hThread = CreateRemoteThread(hProcess, NULL, 0,
+                                          (LPTHREAD_START_ROUTINE)hLoadLibraryA,
+                                          remoteBuffer, 0, &remoteTID);
+      if (hThread == NULL) {
+        std::cerr << "Failed to create remote thread" << std::endl;
+        VirtualFreeEx(hProcess, remoteBuffer, 0, MEM_RELEASE);
+        CloseHandle(hProcess);
+        CloseHandle(outHandle);
+        return 1;
+      }
+      std::cout << "Remote thread ID: " << remoteTID << std::endl;
+      WaitForSingleObject(hThread, INFINITE);
+      DWORD exitCode;
+      GetExitCodeThread(hThread, &exitCode);
+      std::cout << "Exit code: " << exitCode << std::endl;
+      CloseHandle(hThread);
       VirtualFreeEx(hProcess, remoteBuffer, 0, MEM_RELEASE);
-      CloseHandle(hProcess);
-      CloseHandle(outHandle);
-      return 1;
     }
-    std::cout << "Remote thread ID: " << remoteTID << std::endl;
-    WaitForSingleObject(hThread, INFINITE);
-    DWORD exitCode;
-    GetExitCodeThread(hThread, &exitCode);
-    std::cout << "Exit code: " << exitCode << std::endl;
-    CloseHandle(hThread);
-    VirtualFreeEx(hProcess, remoteBuffer, 0, MEM_RELEASE);
   }
   ResumeThread(pi.hThread);
-  CloseHandle(hProcess);
   std::cout << "Congratulations!!! you have been injected :3" << std::endl;
+  if (logFile != "" &&
+      !watchTelemetry(pi.dwProcessId, hProcess, std::chrono::seconds(10))) {
+    std::cout << "Framework telemetry not available; program output goes to "
+              << (logFile == "-" ? "the console" : logFile) << std::endl;
+  }
+  CloseHandle(hProcess);
 
   return 0;
 }
\ No newline at end of file
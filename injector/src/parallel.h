@@ -0,0 +1,31 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+// Calls fn(i) for every i in [0, count) on up to `workers` threads, the
+// calling thread included, and returns once all have run. 0 workers picks
+// the hardware thread count. fn must not throw.
+template <typename Fn>
+void parallelForEach(size_t count, unsigned workers, Fn &&fn) {
+  if (count == 0) return;
+  if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = static_cast<unsigned>(std::min<size_t>(workers, count));
+  std::atomic<size_t> next{0};
+  auto work = [&]() {
+    for (;;) {
+      auto i = next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= count) return;
+      fn(i);
+    }
+  };
+  std::vector<std::future<void>> helpers;
+  for (unsigned i = 1; i < workers; i++) {
+    helpers.push_back(std::async(std::launch::async, work));
+  }
+  work();
+  for (auto &helper : helpers) helper.get();
+}
@@ -0,0 +1,308 @@
+#include "pe_imports.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <set>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Offsets from the PE/COFF specification.
+constexpr size_t kDosLfanew = 0x3C;
+constexpr size_t kCoffHeaderSize = 20;
+constexpr size_t kSectionHeaderSize = 40;
+constexpr size_t kImportDescriptorSize = 20;
+constexpr size_t kDelayDescriptorSize = 32;
+constexpr uint16_t kMagicPe32 = 0x10B;
+constexpr uint16_t kMagicPe32Plus = 0x20B;
+constexpr uint32_t kImportDirectory = 1;
+constexpr uint32_t kDelayImportDirectory = 13;
+// Real images have a few dozen imported DLLs; this only stops a corrupt
+// table from running to the end of the file.
+constexpr size_t kMaxDescriptors = 4096;
+constexpr size_t kMaxNameLength = 260;
+
+class Image {
+public:
+  Image(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+  bool read16(size_t offset, uint16_t &value) const {
+    if (offset > m_size || m_size - offset < 2) return false;
+    value = static_cast<uint16_t>(m_data[offset] | (m_data[offset + 1] << 8));
+    return true;
+  }
+
+  bool read32(size_t offset, uint32_t &value) const {
+    if (offset > m_size || m_size - offset < 4) return false;
+    value = 0;
+    for (int i = 3; i >= 0; i--) value = (value << 8) | m_data[offset + i];
+    return true;
+  }
+
+  bool read64(size_t offset, uint64_t &value) const {
+    uint32_t low, high;
+    if (!read32(offset, low) || !read32(offset + 4, high)) return false;
+    value = (static_cast<uint64_t>(high) << 32) | low;
+    return true;
+  }
+
+  bool readName(size_t offset, std::string &name) const {
+    name.clear();
+    for (size_t i = offset; i < m_size && name.size() < kMaxNameLength; i++) {
+      if (m_data[i] == 0) return !name.empty();
+      name.push_back(static_cast<char>(m_data[i]));
+    }
+    return false;
+  }
+
+private:
+  const uint8_t *m_data;
+  size_t m_size;
+};
+
+struct Section {
+  uint32_t virtualAddress;
+  uint32_t virtualSize;
+  uint32_t rawOffset;
+  uint32_t rawSize;
+};
+
+bool rvaToOffset(const std::vector<Section> &sections, uint32_t rva, size_t &offset) {
+  for (const auto &section : sections) {
+    auto extent = std::max(section.virtualSize, section.rawSize);
+    if (rva >= section.virtualAddress && rva - section.virtualAddress < extent) {
+      auto delta = rva - section.virtualAddress;
+      if (delta >= section.rawSize) return false; // zero-filled, not on disk
+      offset = static_cast<size_t>(section.rawOffset) + delta;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool fail(std::string *error, const char *message) {
+  if (error) *error = message;
+  return false;
+}
+
+std::string lowercase(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return text;
+}
+
+bool isApiSet(const std::string &lowerName) {
+  return lowerName.starts_with("api-ms-win-") || lowerName.starts_with("ext-ms-");
+}
+
+// lowercase file name -> path for every regular file directly in dirs; the
+// first dir wins on collisions.
+std::map<std::string, fs::path> listDlls(const std::vector<fs::path> &dirs) {
+  std::map<std::string, fs::path> files;
+  for (const auto &dir : dirs) {
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+      std::error_code entryEc;
+      if (it->is_regular_file(entryEc)) {
+        files.emplace(lowercase(it->path().filename().string()), it->path());
+      }
+    }
+  }
+  return files;
+}
+
+} // namespace
+
+std::optional<PeImports> parsePeImports(const uint8_t *data, size_t size,
+                                        std::string *error) {
+  Image image(data, size);
+  uint16_t mz;
+  uint32_t peOffset, signature;
+  if (!image.read16(0, mz) || mz != 0x5A4D) {
+    fail(error, "missing MZ header");
+    return std::nullopt;
+  }
+  if (!image.read32(kDosLfanew, peOffset) || !image.read32(peOffset, signature) ||
+      signature != 0x00004550) {
+    fail(error, "missing PE signature");
+    return std::nullopt;
+  }
+
+  const size_t coff = static_cast<size_t>(peOffset) + 4;
+  uint16_t sectionCount, optionalSize, magic;
+  if (!image.read16(coff + 2, sectionCount) || !image.read16(coff + 16, optionalSize)) {
+    fail(error, "truncated COFF header");
+    return std::nullopt;
+  }
+  const size_t optional = coff + kCoffHeaderSize;
+  if (!image.read16(optional, magic) ||
+      (magic != kMagicPe32 && magic != kMagicPe32Plus)) {
+    fail(error, "unknown optional header magic");
+    return std::nullopt;
+  }
+  const bool plus = magic == kMagicPe32Plus;
+
+  uint64_t imageBase = 0;
+  uint32_t directoryCount;
+  bool ok = plus ? image.read64(optional + 24, imageBase) : [&]() {
+    uint32_t base32;
+    bool read = image.read32(optional + 28, base32);
+    imageBase = base32;
+    return read;
+  }();
+  ok = ok && image.read32(optional + (plus ? 108 : 92), directoryCount);
+  if (!ok) {
+    fail(error, "truncated optional header");
+    return std::nullopt;
+  }
+  const size_t directories = optional + (plus ? 112 : 96);
+  auto directoryRva = [&](uint32_t index) -> uint32_t {
+    uint32_t rva = 0;
+    if (index >= directoryCount || directories + index * 8 + 8 > optional + optionalSize) {
+      return 0;
+    }
+    image.read32(directories + index * 8, rva);
+    return rva;
+  };
+
+  std::vector<Section> sections;
+  const size_t sectionTable = optional + optionalSize;
+  for (uint16_t i = 0; i < sectionCount; i++) {
+    const size_t at = sectionTable + i * kSectionHeaderSize;
+    Section section;
+    if (!image.read32(at + 8, section.virtualSize) ||
+        !image.read32(at + 12, section.virtualAddress) ||
+        !image.read32(at + 16, section.rawSize) ||
+        !image.read32(at + 20, section.rawOffset)) {
+      fail(error, "truncated section table");
+      return std::nullopt;
+    }
+    sections.push_back(section);
+  }
+
+  PeImports result;
+  std::string name;
+  size_t offset;
+
+  if (uint32_t rva = directoryRva(kImportDirectory)) {
+    if (!rvaToOffset(sections, rva, offset)) {
+      fail(error, "import directory outside the image");
+      return std::nullopt;
+    }
+    for (size_t i = 0; i < kMaxDescriptors; i++) {
+      const size_t at = offset + i * kImportDescriptorSize;
+      uint32_t nameRva, firstThunk;
+      if (!image.read32(at + 12, nameRva) || !image.read32(at + 16, firstThunk)) {
+        fail(error, "truncated import directory");
+        return std::nullopt;
+      }
+      if (nameRva == 0 && firstThunk == 0) break;
+      size_t nameOffset;
+      if (nameRva != 0 && rvaToOffset(sections, nameRva, nameOffset) &&
+          image.readName(nameOffset, name)) {
+        result.imports.push_back(name);
+      }
+    }
+  }
+
+  if (uint32_t rva = directoryRva(kDelayImportDirectory)) {
+    if (!rvaToOffset(sections, rva, offset)) {
+      fail(error, "delay-import directory outside the image");
+      return std::nullopt;
+    }
+    for (size_t i = 0; i < kMaxDescriptors; i++) {
+      const size_t at = offset + i * kDelayDescriptorSize;
+      uint32_t attributes, nameRva;
+      if (!image.read32(at, attributes) || !image.read32(at + 4, nameRva)) {
+        fail(error, "truncated delay-import directory");
+        return std::nullopt;
+      }
+      if (nameRva == 0) break;
+      // Attribute bit 0 clear means the old VC6 layout, which stores VAs.
+      if ((attributes & 1) == 0) {
+        if (nameRva < imageBase) continue;
+        nameRva = static_cast<uint32_t>(nameRva - imageBase);
+      }
+      size_t nameOffset;
+      if (rvaToOffset(sections, nameRva, nameOffset) && image.readName(nameOffset, name)) {
+        result.delayImports.push_back(name);
+      }
+    }
+  }
+  return result;
+}
+
+std::optional<PeImports> readPeImports(const fs::path &path, std::string *error) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    fail(error, "cannot open file");
+    return std::nullopt;
+  }
+  auto size = static_cast<size_t>(in.tellg());
+  std::vector<uint8_t> data(size);
+  in.seekg(0);
+  if (!in.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size))) {
+    fail(error, "cannot read file");
+    return std::nullopt;
+  }
+  return parsePeImports(data.data(), data.size(), error);
+}
+
+DependencyClosure computeDependencyClosure(const std::vector<fs::path> &roots,
+                                           const std::vector<fs::path> &searchDirs,
+                                           const std::vector<fs::path> &providedDirs,
+                                           const std::vector<std::string> &notProvided,
+                                           unsigned workers) {
+  const auto available = listDlls(searchDirs);
+  auto provided = listDlls(providedDirs);
+  for (const auto &name : notProvided) provided.erase(lowercase(name));
+
+  DependencyClosure closure;
+  std::set<std::string> seen;
+  std::set<std::string> missing;
+  std::vector<fs::path> frontier;
+  for (const auto &root : roots) {
+    if (seen.insert(lowercase(root.filename().string())).second) {
+      frontier.push_back(root);
+    }
+  }
+  bool atRoots = true;
+
+  while (!frontier.empty()) {
+    std::vector<std::optional<PeImports>> parsed(frontier.size());
+    std::vector<std::string> errors(frontier.size());
+    parallelForEach(frontier.size(), workers, [&](size_t i) {
+      parsed[i] = readPeImports(frontier[i], &errors[i]);
+    });
+
+    std::vector<fs::path> next;
+    for (size_t i = 0; i < frontier.size(); i++) {
+      if (!atRoots) closure.files.push_back(frontier[i]);
+      if (!parsed[i]) {
+        closure.unreadable.emplace_back(frontier[i], errors[i]);
+        continue;
+      }
+      auto follow = [&](const std::string &import) {
+        auto name = lowercase(import);
+        if (isApiSet(name) || provided.contains(name) || !seen.insert(name).second) {
+          return;
+        }
+        auto found = available.find(name);
+        if (found == available.end()) {
+          missing.insert(import);
+          return;
+        }
+        next.push_back(found->second);
+      };
+      for (const auto &import : parsed[i]->imports) follow(import);
+      for (const auto &import : parsed[i]->delayImports) follow(import);
+    }
+    frontier = std::move(next);
+    atRoots = false;
+  }
+  closure.missing.assign(missing.begin(), missing.end());
+  return closure;
+}
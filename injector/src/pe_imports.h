@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// DLL names a PE image imports, as written in the image.
+struct PeImports {
+  std::vector<std::string> imports;
+  std::vector<std::string> delayImports;
+};
+
+// Parses the import and delay-import directories of a PE32 or PE32+ image.
+// Only reads the on-disk layout, so it works on any host. Returns nullopt
+// and sets error for anything that is not a well-formed PE image.
+std::optional<PeImports> parsePeImports(const uint8_t *data, size_t size,
+                                        std::string *error = nullptr);
+
+std::optional<PeImports> readPeImports(const std::filesystem::path &path,
+                                       std::string *error = nullptr);
+
+struct DependencyClosure {
+  // Dependencies found in the search dirs, excluding the roots.
+  std::vector<std::filesystem::path> files;
+  // Imports found neither in the search dirs nor in the provided dirs.
+  std::vector<std::string> missing;
+  // Files that could not be parsed, with the reason.
+  std::vector<std::pair<std::filesystem::path, std::string>> unreadable;
+};
+
+// Follows imports and delay imports from roots through the DLLs in
+// searchDirs. Names present in providedDirs (the program's install dir,
+// the system dir) or that are API set contracts are never deployed and
+// never followed, except for notProvided: files in providedDirs that an
+// earlier deploy put there, which are resolved like any other name. Names
+// match case-insensitively, as the Windows loader does. Each level of the
+// walk is parsed in parallel.
+DependencyClosure
+computeDependencyClosure(const std::vector<std::filesystem::path> &roots,
+                         const std::vector<std::filesystem::path> &searchDirs,
+                         const std::vector<std::filesystem::path> &providedDirs,
+                         const std::vector<std::string> &notProvided = {},
+                         unsigned workers = 0);
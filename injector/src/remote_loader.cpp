@@ -0,0 +1,95 @@
+#include "remote_loader.h"
+#include <algorithm>
+
+namespace remote_loader {
+
+namespace {
+
+// x64, Microsoft calling convention; rcx holds the data header.
+//
+//   push rbx / push rsi / push rdi / push r12 / sub rsp, 40
+//   mov rbx, rcx / xor esi, esi / xor edi, edi
+// loop:
+//   cmp esi, [rbx+16] / jae done
+//   mov eax, esi / shl rax, 4 / lea r12, [rbx+rax+32]
+//   mov ecx, [r12] / add rcx, rbx / call [rbx]         ; LoadLibraryW
+//   mov [r12+8], rax / test rax, rax / jnz ok
+//   call [rbx+8] / mov [r12+4], eax / jmp next        ; GetLastError
+// ok:   inc edi
+// next: inc esi / jmp loop
+// done:
+//   mov [rbx+20], edi / mov eax, edi
+//   add rsp, 40 / pop r12 / pop rdi / pop rsi / pop rbx / ret
+constexpr uint8_t kStub[] = {
+    0x53, 0x56, 0x57, 0x41, 0x54, 0x48, 0x83, 0xec, 0x28, 0x48, 0x89, 0xcb,
+    0x31, 0xf6, 0x31, 0xff, 0x3b, 0x73, 0x10, 0x73, 0x2e, 0x89, 0xf0, 0x48,
+    0xc1, 0xe0, 0x04, 0x4c, 0x8d, 0x64, 0x03, 0x20, 0x41, 0x8b, 0x0c, 0x24,
+    0x48, 0x01, 0xd9, 0xff, 0x13, 0x49, 0x89, 0x44, 0x24, 0x08, 0x48, 0x85,
+    0xc0, 0x75, 0x0a, 0xff, 0x53, 0x08, 0x41, 0x89, 0x44, 0x24, 0x04, 0xeb,
+    0x02, 0xff, 0xc7, 0xff, 0xc6, 0xeb, 0xcd, 0x89, 0x7b, 0x14, 0x89, 0xf8,
+    0x48, 0x83, 0xc4, 0x28, 0x41, 0x5c, 0x5f, 0x5e, 0x5b, 0xc3};
+static_assert(sizeof(kStub) <= kCodeSize);
+
+void put32(std::vector<uint8_t> &bytes, size_t offset, uint32_t value) {
+  for (int i = 0; i < 4; i++) bytes[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+void put64(std::vector<uint8_t> &bytes, size_t offset, uint64_t value) {
+  put32(bytes, offset, static_cast<uint32_t>(value));
+  put32(bytes, offset + 4, static_cast<uint32_t>(value >> 32));
+}
+
+uint32_t get32(const uint8_t *data, size_t offset) {
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; i--) value = (value << 8) | data[offset + i];
+  return value;
+}
+
+} // namespace
+
+Payload buildPayload(const std::vector<std::u16string> &paths,
+                     uint64_t loadLibraryW, uint64_t getLastError) {
+  Payload payload;
+  size_t dataSize = kHeaderSize + paths.size() * kEntrySize;
+  for (const auto &path : paths) dataSize += (path.size() + 1) * 2;
+  payload.bytes.assign(kCodeSize + dataSize, 0);
+  std::copy(std::begin(kStub), std::end(kStub), payload.bytes.begin());
+
+  const size_t header = payload.dataOffset;
+  put64(payload.bytes, header, loadLibraryW);
+  put64(payload.bytes, header + 8, getLastError);
+  put32(payload.bytes, header + 16, static_cast<uint32_t>(paths.size()));
+
+  size_t stringOffset = kHeaderSize + paths.size() * kEntrySize;
+  for (size_t i = 0; i < paths.size(); i++) {
+    put32(payload.bytes, header + kHeaderSize + i * kEntrySize,
+          static_cast<uint32_t>(stringOffset));
+    for (char16_t c : paths[i]) {
+      payload.bytes[header + stringOffset] = static_cast<uint8_t>(c);
+      payload.bytes[header + stringOffset + 1] = static_cast<uint8_t>(c >> 8);
+      stringOffset += 2;
+    }
+    stringOffset += 2; // terminator, already zero
+  }
+  return payload;
+}
+
+std::vector<LoadResult> readResults(const uint8_t *data, size_t size,
+                                    size_t count) {
+  std::vector<LoadResult> results;
+  if (size < kHeaderSize || (size - kHeaderSize) / kEntrySize < count) {
+    return results;
+  }
+  results.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    const size_t entry = kHeaderSize + i * kEntrySize;
+    LoadResult result;
+    result.error = get32(data, entry + 4);
+    result.module = get32(data, entry + 8) |
+                    (static_cast<uint64_t>(get32(data, entry + 12)) << 32);
+    results.push_back(result);
+  }
+  return results;
+}
+
+} // namespace remote_loader
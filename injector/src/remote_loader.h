@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A single-allocation payload that loads several DLLs in the target from
+// one remote thread. The first page holds a small position-independent x64
+// stub; the data page after it starts with a header the stub reads through
+// its thread parameter:
+//
+//   +0   u64  LoadLibraryW
+//   +8   u64  GetLastError
+//   +16  u32  entry count
+//   +20  u32  DLLs loaded (written by the stub)
+//   +32  entries, 16 bytes each:
+//          u32 path offset from the header, u32 GetLastError on failure,
+//          u64 returned HMODULE
+//   ...  NUL-terminated UTF-16 paths
+//
+// The stub loads the paths in order and returns the number loaded, which
+// becomes the thread's exit code.
+namespace remote_loader {
+
+constexpr size_t kCodeSize = 0x1000;
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kEntrySize = 16;
+
+struct Payload {
+  std::vector<uint8_t> bytes;
+  // Offset of the data header; the remote thread's parameter is
+  // base + dataOffset, and only [0, kCodeSize) needs to be executable.
+  size_t dataOffset = kCodeSize;
+};
+
+struct LoadResult {
+  uint64_t module = 0;
+  uint32_t error = 0;
+};
+
+Payload buildPayload(const std::vector<std::u16string> &paths,
+                     uint64_t loadLibraryW, uint64_t getLastError);
+
+// Decodes the entries from a copy of the data region read back from the
+// target. Returns an empty vector if the region is too short.
+std::vector<LoadResult> readResults(const uint8_t *data, size_t size,
+                                    size_t count);
+
+} // namespace remote_loader
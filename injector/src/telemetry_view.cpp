@@ -0,0 +1,96 @@
+#include "telemetry_view.h"
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+
+std::string formatTelemetryRecord(const util::telemetry::RecordView &record) {
+  using util::telemetry::RecordKind;
+  static constexpr char kLevelChars[] = {'T', 'D', 'I', 'W', 'E'};
+  const auto nanos = record.header->timestamp;
+  const std::time_t seconds = static_cast<std::time_t>(nanos / 1000000000);
+  const int millis = static_cast<int>((nanos / 1000000) % 1000);
+  std::tm local{};
+#ifdef _WIN32
+  localtime_s(&local, &seconds);
+#else
+  localtime_r(&seconds, &local);
+#endif
+  char prefix[64];
+  char level = record.header->kind == RecordKind::Metrics ? 'M'
+               : record.header->level < sizeof(kLevelChars)
+                   ? kLevelChars[record.header->level]
+                   : '?';
+  std::snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%03d %c %5u [",
+                local.tm_hour, local.tm_min, local.tm_sec, millis, level,
+                static_cast<unsigned>(record.header->threadId));
+  std::string line = prefix;
+  line += record.source();
+  line += "] ";
+  line += record.payload;
+  return line;
+}
+
+#ifdef _WIN32
+bool watchTelemetry(DWORD pid, HANDLE hProcess,
+                    std::chrono::milliseconds attachTimeout) {
+  using namespace util::telemetry;
+  const auto size = mappingSize(kDefaultCapacity);
+  const auto deadline = std::chrono::steady_clock::now() + attachTimeout;
+  HANDLE mapping = NULL;
+  // The framework creates the ring while its dll initializes, shortly after
+  // the target resumes.
+  while (!(mapping = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE,
+                                      mappingName(pid).c_str()))) {
+    if (std::chrono::steady_clock::now() >= deadline ||
+        WaitForSingleObject(hProcess, 50) == WAIT_OBJECT_0) {
+      return false;
+    }
+  }
+  void *view =
+      MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size);
+  HANDLE event =
+      OpenEventA(SYNCHRONIZE, FALSE, eventName(pid).c_str());
+  if (!view || !event) {
+    if (view) UnmapViewOfFile(view);
+    if (event) CloseHandle(event);
+    CloseHandle(mapping);
+    return false;
+  }
+
+  RingReader reader(view);
+  std::uint64_t reportedDropped = 0;
+  auto drain = [&]() {
+    while (auto record = reader.peek()) {
+      std::cout << formatTelemetryRecord(*record) << '\n';
+      reader.consume();
+    }
+    if (reader.dropped() > reportedDropped) {
+      std::cout << "[telemetry] " << reader.dropped() - reportedDropped
+                << " records dropped (ring full)\n";
+      reportedDropped = reader.dropped();
+    }
+    std::cout.flush();
+  };
+
+  std::cout << "Watching framework telemetry" << std::endl;
+  bool exited = false;
+  while (!exited && reader.valid()) {
+    drain();
+    reader.prepareWait();
+    if (!reader.peek()) {
+      HANDLE handles[] = {event, hProcess};
+      exited = WaitForMultipleObjects(2, handles, FALSE, INFINITE) ==
+               WAIT_OBJECT_0 + 1;
+    }
+    reader.finishWait();
+  }
+  drain();
+  if (!reader.valid()) {
+    std::cerr << "[telemetry] ring is corrupt; stopped watching" << std::endl;
+  }
+  UnmapViewOfFile(view);
+  CloseHandle(event);
+  CloseHandle(mapping);
+  return true;
+}
+#endif
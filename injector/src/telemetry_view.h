@@ -0,0 +1,20 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <toon_boom/ext/telemetry_ring.hpp>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// One line, without the trailing newline, e.g.
+// "12:04:05.123 I  4312 [hooks] Hooks initialized".
+std::string formatTelemetryRecord(const util::telemetry::RecordView &record);
+
+#ifdef _WIN32
+// Renders the framework's telemetry ring for process pid to stdout until the
+// process exits. Gives up and returns false if the ring has not appeared
+// within attachTimeout, in which case the target's own stdout is all there
+// is.
+bool watchTelemetry(DWORD pid, HANDLE hProcess,
+                    std::chrono::milliseconds attachTimeout);
+#endif
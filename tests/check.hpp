@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdlib>
+#include <iostream>
+
+// Minimal assertions for the portable test executables. A failed CHECK
+// reports and keeps going; the executable exits non-zero if any failed.
+inline int &checkFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition        \
+                << ") failed" << std::endl;                                    \
+      checkFailures()++;                                                       \
+    }                                                                          \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                             \
+  do {                                                                         \
+    const auto &checkActual = (actual);                                        \
+    const auto &checkExpected = (expected);                                    \
+    if (!(checkActual == checkExpected)) {                                     \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", "   \
+                << #expected << ") failed: " << checkActual                    \
+                << " != " << checkExpected << std::endl;                       \
+      checkFailures()++;                                                       \
+    }                                                                          \
+  } while (0)
+
+inline int checkResult() {
+  if (checkFailures() == 0) return EXIT_SUCCESS;
+  std::cerr << checkFailures() << " check(s) failed" << std::endl;
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,219 @@
+#include "check.hpp"
+#include "farm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Stands in for starting Harmony: each job's args say what to do.
+//   "sleep=<ms> exit=<code>"  sleeps, then exits with code
+//   "fail"                     cannot be started
+//   "throw"                    the launcher throws
+class FakeLauncher : public ProcessLauncher {
+public:
+  std::optional<int> run(const FarmJob &job, std::string &error) override {
+    {
+      std::lock_guard lock(m_mutex);
+      m_started.push_back(job.name);
+    }
+    const int running = ++m_running;
+    int peak = m_peak.load();
+    while (running > peak && !m_peak.compare_exchange_weak(peak, running)) {
+    }
+
+    int sleepMs = 10;
+    int exitCode = 0;
+    std::istringstream words(job.args);
+    for (std::string word; words >> word;) {
+      if (word.starts_with("sleep=")) sleepMs = std::stoi(word.substr(6));
+      if (word.starts_with("exit=")) exitCode = std::stoi(word.substr(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+    --m_running;
+
+    if (job.args == "fail") {
+      error = "could not start " + job.program.filename().string();
+      return std::nullopt;
+    }
+    if (job.args == "throw") throw std::runtime_error("launcher threw");
+    return exitCode;
+  }
+
+  std::vector<std::string> started() {
+    std::lock_guard lock(m_mutex);
+    return m_started;
+  }
+  int peak() const { return m_peak.load(); }
+
+private:
+  std::mutex m_mutex;
+  std::vector<std::string> m_started;
+  std::atomic<int> m_running{0};
+  std::atomic<int> m_peak{0};
+};
+
+FarmJob job(const std::string &name, const std::string &args) {
+  FarmJob result;
+  result.name = name;
+  result.program = "Harmony.exe";
+  result.args = args;
+  return result;
+}
+
+void testConcurrencyAndOrder() {
+  std::vector<FarmJob> jobs;
+  for (int i = 0; i < 12; i++) {
+    jobs.push_back(job("job" + std::to_string(i), "sleep=30"));
+  }
+  for (unsigned cap : {1u, 3u}) {
+    FakeLauncher launcher;
+    std::atomic<int> inCallback{0};
+    std::atomic<int> overlapping{0};
+    std::vector<std::string> finished;
+    auto results = runFarm(jobs, launcher, cap, [&](const FarmResult &result) {
+      if (++inCallback > 1) overlapping++;
+      finished.push_back(result.name);
+      std::this_thread::sleep_for(2ms);
+      --inCallback;
+    });
+
+    CHECK(launcher.peak() <= static_cast<int>(cap));
+    CHECK_EQ(launcher.peak(), static_cast<int>(cap));
+    CHECK_EQ(overlapping.load(), 0);
+    CHECK_EQ(finished.size(), jobs.size());
+
+    // Jobs are handed out in manifest order, so each starts at most
+    // cap - 1 places from its index; with one slot the order is exact.
+    auto started = launcher.started();
+    CHECK_EQ(started.size(), jobs.size());
+    for (size_t i = 0; i < started.size(); i++) {
+      auto index = static_cast<size_t>(std::stoi(started[i].substr(3)));
+      CHECK((index > i ? index - i : i - index) < cap);
+    }
+    CHECK_EQ(results.size(), jobs.size());
+    for (size_t i = 0; i < results.size(); i++) {
+      CHECK_EQ(results[i].name, jobs[i].name);
+    }
+  }
+}
+
+void testResults() {
+  std::vector<FarmJob> jobs = {job("ok", "sleep=5 exit=0"),
+                               job("slow", "sleep=80 exit=3"),
+                               job("fail", "fail"), job("throw", "throw")};
+  FakeLauncher launcher;
+  auto results = runFarm(jobs, launcher, 0);
+  CHECK_EQ(results.size(), size_t{4});
+  if (results.size() != 4) return;
+
+  CHECK(results[0].exitCode == 0);
+  CHECK(results[0].error.empty());
+  CHECK(results[1].exitCode == 3);
+  CHECK(results[1].wallTime >= 80ms);
+  CHECK(results[0].wallTime < results[1].wallTime);
+  CHECK(!results[2].exitCode);
+  CHECK_EQ(results[2].error, "could not start Harmony.exe");
+  CHECK(!results[3].exitCode);
+  CHECK_EQ(results[3].error, "launcher threw");
+  // concurrency 0 still runs one at a time rather than none.
+  CHECK_EQ(launcher.peak(), 1);
+}
+
+std::optional<FarmManifest> parse(const std::string &text, std::string &error) {
+  std::istringstream in(text);
+  error.clear();
+  return parseFarmManifest(in, fs::path("/base"), &error);
+}
+
+void testParse() {
+  std::string error;
+  auto manifest = parse(
+      "; comment\n"
+      "[farm]\n"
+      "concurrency = 8\n"
+      "memory-per-job-mb = 3072\n"
+      "dep-dir = deps\n"
+      "dep-dir = /opt/deps\n"
+      "\n"
+      "[shot_010]\n"
+      "  program = /apps/Harmony.exe  \n"
+      "args = -batch -scene 010.xstage\n"
+      "dll = ext.dll\n"
+      "dll = /build/more.dll\n"
+      "dep = extra.dll\n"
+      "# another comment\n"
+      "log = logs/010.log\n"
+      "[ shot_020 ]\n"
+      "program = Harmony.exe\n",
+      error);
+  CHECK(manifest);
+  CHECK_EQ(error, "");
+  if (!manifest) return;
+  CHECK_EQ(manifest->concurrency, 8u);
+  CHECK_EQ(manifest->memoryPerJob, uint64_t{3072} << 20);
+  CHECK(manifest->depDirs ==
+        std::vector<fs::path>({fs::path("/base/deps"), fs::path("/opt/deps")}));
+  CHECK_EQ(manifest->jobs.size(), size_t{2});
+  if (manifest->jobs.size() != 2) return;
+  const auto &first = manifest->jobs[0];
+  CHECK_EQ(first.name, "shot_010");
+  CHECK(first.program == fs::path("/apps/Harmony.exe"));
+  CHECK_EQ(first.args, "-batch -scene 010.xstage");
+  CHECK(first.dlls ==
+        std::vector<fs::path>({fs::path("/base/ext.dll"), fs::path("/build/more.dll")}));
+  CHECK(first.deps == std::vector<fs::path>({fs::path("/base/extra.dll")}));
+  CHECK(first.logFile == fs::path("/base/logs/010.log"));
+  CHECK_EQ(manifest->jobs[1].name, "shot_020");
+  CHECK(manifest->jobs[1].program == fs::path("/base/Harmony.exe"));
+  CHECK(manifest->jobs[1].logFile.empty());
+
+  // UTF-8 paths come through unchanged.
+  manifest = parse("[j]\nprogram = /caf\xc3\xa9/Harmony.exe\n", error);
+  CHECK(manifest);
+  if (manifest) {
+    CHECK(manifest->jobs[0].program.u8string() == u8"/café/Harmony.exe");
+  }
+
+  CHECK(!parse("[j]\nprogram = a\nflavour = b\n", error));
+  CHECK_EQ(error, "line 3: unknown job key 'flavour'");
+  CHECK(!parse("[farm]\nthreads = 2\n", error));
+  CHECK_EQ(error, "line 2: unknown farm key 'threads'");
+  CHECK(!parse("program = a\n", error));
+  CHECK_EQ(error, "line 1: key outside of a section");
+  CHECK(!parse("[a]\nprogram = a\n[b]\nargs = x\n", error));
+  CHECK_EQ(error, "job 'b' has no program");
+  CHECK(!parse("[farm]\nconcurrency = many\n", error));
+  CHECK_EQ(error, "line 2: 'concurrency' expects a number");
+  CHECK(!parse("[farm]\nconcurrency = 8x\n", error));
+  CHECK_EQ(error, "line 2: 'concurrency' expects a number");
+  CHECK(!parse("[farm]\nconcurrency = -1\n", error));
+  CHECK_EQ(error, "line 2: 'concurrency' expects a number");
+  CHECK(!parse("[farm]\nmemory-per-job-mb = 99999999999999999999\n", error));
+  CHECK_EQ(error, "line 2: 'memory-per-job-mb' expects a number");
+  CHECK(!parse("[j\nprogram = a\n", error));
+  CHECK_EQ(error, "line 1: unterminated section header");
+  CHECK(!parse("[ ]\n", error));
+  CHECK_EQ(error, "line 1: empty section name");
+  CHECK(!parse("[j]\nprogram\n", error));
+  CHECK_EQ(error, "line 2: expected key = value");
+}
+
+} // namespace
+
+int main() {
+  testConcurrencyAndOrder();
+  testResults();
+  testParse();
+  return checkResult();
+}
@@ -0,0 +1,148 @@
+#include "check.hpp"
+#include "finder.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// An install tree under a fresh temporary directory, removed on exit.
+class FakeTree {
+public:
+  FakeTree() {
+    m_root = fs::temp_directory_path() /
+             ("tb-finder-test-" + std::to_string(std::random_device()()));
+    fs::remove_all(m_root);
+    fs::create_directories(m_root / "roots");
+  }
+  ~FakeTree() {
+    std::error_code ec;
+    fs::remove_all(m_root, ec);
+  }
+
+  fs::path root() const { return m_root / "roots"; }
+  fs::path cache() const { return m_root / "cache" / "installs.idx"; }
+
+  fs::path addFile(const fs::path &relative) {
+    auto path = root() / relative;
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << "MZ";
+    return path;
+  }
+
+private:
+  fs::path m_root;
+};
+
+std::string join(const std::vector<std::string> &items) {
+  std::string text;
+  for (const auto &item : items) text += (text.empty() ? "" : ",") + item;
+  return text;
+}
+
+std::string relativeNames(const FinderOptions &options, const fs::path &root) {
+  std::vector<std::string> paths;
+  for (const auto &[product, entry] : findToonBoomVersions(options)) {
+    paths.push_back(fs::relative(entry.path(), root).generic_string());
+  }
+  std::sort(paths.begin(), paths.end());
+  return join(paths);
+}
+
+void testWalk() {
+  FakeTree tree;
+  tree.addFile("Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe");
+  // Depth 3 below the product is the deepest a maxDepth of 4 looks.
+  tree.addFile("Toon Boom Storyboard Pro 24/a/b/c/StoryboardPro.exe");
+  tree.addFile("Toon Boom Storyboard Pro 24/a/b/c/d/HarmonyAdvanced.exe");
+  tree.addFile("Toon Boom Harmony 22 Premium/Resources/HarmonyEssentials.exe");
+  tree.addFile("Toon Boom Harmony 22 Premium/win64/bin/NotHarmony.exe");
+  tree.addFile("Other Vendor/HarmonyPremium.exe");
+
+  FinderOptions options;
+  options.roots = {tree.root()};
+  CHECK_EQ(relativeNames(options, tree.root()),
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe,"
+           "Toon Boom Storyboard Pro 24/a/b/c/StoryboardPro.exe");
+
+  options.maxDepth = 5;
+  options.prunedDirs.clear();
+  CHECK_EQ(relativeNames(options, tree.root()),
+           "Toon Boom Harmony 22 Premium/Resources/HarmonyEssentials.exe,"
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe,"
+           "Toon Boom Storyboard Pro 24/a/b/c/StoryboardPro.exe,"
+           "Toon Boom Storyboard Pro 24/a/b/c/d/HarmonyAdvanced.exe");
+
+  auto products = findToonBoomVersions(options);
+  CHECK_EQ(products.size(), size_t{4});
+  for (const auto &[product, entry] : products) {
+    CHECK(product.starts_with("Toon Boom"));
+  }
+}
+
+void testCache() {
+  FakeTree tree;
+  tree.addFile("Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe");
+  FinderOptions options;
+  options.roots = {tree.root()};
+  options.cachePath = tree.cache();
+
+  const auto cold = relativeNames(options, tree.root());
+  CHECK_EQ(cold, "Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe");
+  CHECK(fs::exists(tree.cache()));
+
+  // Nothing a cache check stats changes when a file appears two levels
+  // below a product, so the warm run answers from the index without it.
+  tree.addFile("Toon Boom Harmony 22 Premium/win64/bin/HarmonyAdvanced.exe");
+  CHECK_EQ(relativeNames(options, tree.root()), cold);
+
+  // Other settings are a miss even though the tree looks unchanged.
+  auto deeper = options;
+  deeper.maxDepth = 5;
+  CHECK_EQ(relativeNames(deeper, tree.root()),
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyAdvanced.exe,"
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe");
+  tree.addFile("Toon Boom Harmony 22 Premium/win64/bin/HarmonyEssentials.exe");
+  auto unpruned = deeper;
+  unpruned.prunedDirs.erase("python");
+  CHECK_EQ(relativeNames(unpruned, tree.root()),
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyAdvanced.exe,"
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyEssentials.exe,"
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe");
+
+  // A new product directory changes the root's mtime.
+  tree.addFile("Toon Boom Storyboard Pro 24/win64/bin/StoryboardPro.exe");
+  CHECK_EQ(relativeNames(unpruned, tree.root()),
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyAdvanced.exe,"
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyEssentials.exe,"
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe,"
+           "Toon Boom Storyboard Pro 24/win64/bin/StoryboardPro.exe");
+
+  // A removed executable is noticed even though no mtime checked changes.
+  fs::remove(tree.root() / "Toon Boom Harmony 22 Premium/win64/bin/HarmonyPremium.exe");
+  CHECK_EQ(relativeNames(unpruned, tree.root()),
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyAdvanced.exe,"
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyEssentials.exe,"
+           "Toon Boom Storyboard Pro 24/win64/bin/StoryboardPro.exe");
+
+  // A damaged index is ignored rather than trusted.
+  std::ofstream(tree.cache(), std::ios::trunc) << "toon-boom-installs 2\nroot\tx\n";
+  CHECK_EQ(relativeNames(unpruned, tree.root()),
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyAdvanced.exe,"
+           "Toon Boom Harmony 22 Premium/win64/bin/HarmonyEssentials.exe,"
+           "Toon Boom Storyboard Pro 24/win64/bin/StoryboardPro.exe");
+}
+
+} // namespace
+
+int main() {
+  testWalk();
+  testCache();
+  return checkResult();
+}
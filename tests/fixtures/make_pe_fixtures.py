@@ -0,0 +1,165 @@
+"""Writes the PE fixtures used by pe_imports_test.
+
+The images are the smallest well-formed DLLs that carry an import and a
+delay-import directory: headers plus one .idata section. No code, so they
+can be produced on any host without a Windows toolchain. Rerun after
+changing this script and commit the outputs:
+
+    python3 tests/fixtures/make_pe_fixtures.py
+"""
+
+import os
+import struct
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+FILE_ALIGNMENT = 0x200
+SECTION_ALIGNMENT = 0x1000
+SECTION_RVA = 0x1000
+HEADERS_SIZE = 0x200
+PE_OFFSET = 0x40
+
+
+def align(value, to):
+    return (value + to - 1) // to * to
+
+
+class Section:
+    """Lays out .idata, handing out RVAs as data is appended."""
+
+    def __init__(self):
+        self.data = bytearray()
+
+    def rva(self):
+        return SECTION_RVA + len(self.data)
+
+    def add(self, blob, alignment=2):
+        while len(self.data) % alignment:
+            self.data.append(0)
+        at = self.rva()
+        self.data += blob
+        return at
+
+    def patch(self, rva, blob):
+        offset = rva - SECTION_RVA
+        self.data[offset:offset + len(blob)] = blob
+
+
+def build(plus, imports, delay_imports, image_base):
+    """imports: DLL names. delay_imports: (name, legacy) pairs; legacy
+    descriptors use the VC6 layout, which stores VAs instead of RVAs."""
+    pointer = 8 if plus else 4
+    ordinal_flag = 1 << (63 if plus else 31)
+    pack_pointer = (lambda v: struct.pack("<Q", v)) if plus else \
+        (lambda v: struct.pack("<I", v))
+    idata = Section()
+
+    def thunk_table(symbol):
+        hint_name = idata.add(struct.pack("<H", 0) + symbol + b"\0")
+        return pack_pointer(hint_name) + pack_pointer(0)
+
+    # Import descriptors, zero-terminated; patched once names exist.
+    descriptors = idata.add(bytes(20 * (len(imports) + 1)), 4)
+    for i, name in enumerate(imports):
+        name_rva = idata.add(name.encode() + b"\0")
+        lookup = idata.add(thunk_table(b"Function%d" % i), pointer)
+        address = idata.add(thunk_table(b"Function%d" % i), pointer)
+        idata.patch(descriptors + 20 * i,
+                    struct.pack("<IIIII", lookup, 0, 0, name_rva, address))
+
+    delay = 0
+    if delay_imports:
+        delay = idata.add(bytes(32 * (len(delay_imports) + 1)), 4)
+        for i, (name, legacy) in enumerate(delay_imports):
+            name_rva = idata.add(name.encode() + b"\0")
+            handle = idata.add(bytes(pointer), pointer)
+            address = idata.add(pack_pointer(ordinal_flag | 1) + pack_pointer(0),
+                                pointer)
+            lookup = idata.add(pack_pointer(ordinal_flag | 1) + pack_pointer(0),
+                               pointer)
+            fields = [name_rva, handle, address, lookup]
+            if legacy:
+                fields = [image_base + rva for rva in fields]
+            idata.patch(delay + 32 * i,
+                        struct.pack("<IIIIIIII", 0 if legacy else 1, *fields,
+                                    0, 0, 0))
+
+    raw_size = align(len(idata.data), FILE_ALIGNMENT)
+    virtual_size = len(idata.data)
+    size_of_image = SECTION_RVA + align(virtual_size, SECTION_ALIGNMENT)
+
+    directories = [(0, 0)] * 16
+    directories[1] = (descriptors, 20 * (len(imports) + 1))
+    if delay_imports:
+        directories[13] = (delay, 32 * (len(delay_imports) + 1))
+
+    optional = bytearray()
+    optional += struct.pack("<HBBIII", 0x20B if plus else 0x10B, 14, 0, 0,
+                            raw_size, 0)
+    optional += struct.pack("<II", 0, SECTION_RVA)  # entry point, code base
+    if plus:
+        optional += struct.pack("<Q", image_base)
+    else:
+        optional += struct.pack("<II", SECTION_RVA, image_base)
+    optional += struct.pack("<IIHHHHHHIIII", SECTION_ALIGNMENT, FILE_ALIGNMENT,
+                            6, 0, 0, 0, 6, 0, 0, size_of_image, HEADERS_SIZE, 0)
+    optional += struct.pack("<HH", 2, 0x0160 if plus else 0x0140)
+    stack_heap = (0x100000, 0x1000, 0x100000, 0x1000)
+    optional += struct.pack("<QQQQ" if plus else "<IIII", *stack_heap)
+    optional += struct.pack("<II", 0, 16)
+    for rva, size in directories:
+        optional += struct.pack("<II", rva, size)
+
+    coff = struct.pack("<HHIIIHH", 0x8664 if plus else 0x14C, 1, 0, 0, 0,
+                       len(optional), 0x2022 if plus else 0x2102)
+    section = struct.pack("<8sIIIIIIHHI", b".idata", virtual_size, SECTION_RVA,
+                          raw_size, HEADERS_SIZE, 0, 0, 0, 0, 0xC0000040)
+
+    image = bytearray(HEADERS_SIZE)
+    image[0:2] = b"MZ"
+    image[0x3C:0x40] = struct.pack("<I", PE_OFFSET)
+    headers = b"PE\0\0" + coff + bytes(optional) + section
+    assert PE_OFFSET + len(headers) <= HEADERS_SIZE
+    image[PE_OFFSET:PE_OFFSET + len(headers)] = headers
+    image += idata.data
+    image += bytes(HEADERS_SIZE + raw_size - len(image))
+    return bytes(image), descriptors
+
+
+def write(name, data):
+    with open(os.path.join(HERE, name), "wb") as out:
+        out.write(data)
+
+
+def main():
+    pe32, _ = build(False, ["KERNEL32.dll", "dep_b.dll"],
+                    [("dep_a.dll", False), ("legacy_delay.dll", True)],
+                    0x10000000)
+    pe64, descriptors64 = build(True, ["KERNEL32.dll", "USER32.dll",
+                                       "pe32.dll"],
+                                [("dep_c.dll", False)], 0x180000000)
+    write("pe32.dll", pe32)
+    write("pe64.dll", pe64)
+
+    # Cut off inside the COFF header.
+    write("truncated_header.dll", pe64[:0x50])
+    # The section table promises more than the file holds, so the import
+    # descriptors run off the end.
+    write("truncated_imports.dll",
+          pe64[:HEADERS_SIZE + descriptors64 - SECTION_RVA + 30])
+
+    corrupt = bytearray(pe64)
+    optional = PE_OFFSET + 4 + 20
+    corrupt[optional:optional + 2] = struct.pack("<H", 0x107)
+    write("corrupt_magic.dll", corrupt)
+
+    corrupt = bytearray(pe64)
+    import_directory = optional + 112 + 8
+    corrupt[import_directory:import_directory + 4] = struct.pack("<I", 0x7FFF0000)
+    write("corrupt_import_rva.dll", corrupt)
+
+    write("not_pe.dll", b"This is not a portable executable.\n")
+
+
+if __name__ == "__main__":
+    main()
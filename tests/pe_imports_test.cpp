@@ -0,0 +1,144 @@
+#include "check.hpp"
+#include "pe_imports.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const fs::path kFixtures = TB_TEST_FIXTURES_DIR;
+
+std::vector<std::string> sorted(std::vector<std::string> names) {
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+std::string join(const std::vector<std::string> &names) {
+  std::string text;
+  for (const auto &name : names) text += (text.empty() ? "" : ",") + name;
+  return text;
+}
+
+std::string parseError(const char *fixture) {
+  std::string error;
+  auto imports = readPeImports(kFixtures / fixture, &error);
+  CHECK(!imports);
+  return error;
+}
+
+void testPe32() {
+  std::string error;
+  auto imports = readPeImports(kFixtures / "pe32.dll", &error);
+  CHECK(imports);
+  if (!imports) return;
+  CHECK_EQ(join(imports->imports), "KERNEL32.dll,dep_b.dll");
+  // legacy_delay.dll uses the VC6 descriptor layout, which holds VAs.
+  CHECK_EQ(join(imports->delayImports), "dep_a.dll,legacy_delay.dll");
+}
+
+void testPe32Plus() {
+  std::string error;
+  auto imports = readPeImports(kFixtures / "pe64.dll", &error);
+  CHECK(imports);
+  if (!imports) return;
+  CHECK_EQ(join(imports->imports), "KERNEL32.dll,USER32.dll,pe32.dll");
+  CHECK_EQ(join(imports->delayImports), "dep_c.dll");
+}
+
+void testMalformed() {
+  CHECK_EQ(parseError("not_pe.dll"), "missing MZ header");
+  CHECK_EQ(parseError("truncated_header.dll"), "truncated COFF header");
+  CHECK_EQ(parseError("truncated_imports.dll"), "truncated import directory");
+  CHECK_EQ(parseError("corrupt_magic.dll"), "unknown optional header magic");
+  CHECK_EQ(parseError("corrupt_import_rva.dll"),
+           "import directory outside the image");
+  CHECK_EQ(parseError("does_not_exist.dll"), "cannot open file");
+}
+
+// Every prefix of a valid image must fail cleanly or parse, never read out
+// of bounds; run under a sanitizer to make that check meaningful.
+void testEveryTruncation() {
+  std::string error;
+  for (const char *fixture : {"pe32.dll", "pe64.dll"}) {
+    std::ifstream in(kFixtures / fixture, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+    CHECK(parsePeImports(data.data(), data.size(), &error));
+    for (size_t size = 0; size < data.size(); size++) {
+      std::vector<uint8_t> prefix(data.begin(), data.begin() + size);
+      parsePeImports(prefix.data(), prefix.size(), &error);
+    }
+  }
+}
+
+struct TempDir {
+  fs::path path;
+  TempDir() {
+    path = fs::temp_directory_path() /
+           ("pe_imports_test_" + std::to_string(std::rand()));
+    fs::remove_all(path);
+    fs::create_directories(path / "deps");
+    fs::create_directories(path / "install");
+  }
+  ~TempDir() {
+    std::error_code ec;
+    fs::remove_all(path, ec);
+  }
+  void put(const char *fixture, const fs::path &as) {
+    fs::copy_file(kFixtures / fixture, path / as,
+                  fs::copy_options::overwrite_existing);
+  }
+};
+
+std::vector<std::string> fileNames(const std::vector<fs::path> &files) {
+  std::vector<std::string> names;
+  for (const auto &file : files) names.push_back(file.filename().string());
+  return sorted(names);
+}
+
+void testClosure() {
+  TempDir dir;
+  // pe64.dll imports pe32.dll, which imports dep_b.dll and delay-loads
+  // dep_a.dll; those two are stand-ins that import nothing further.
+  dir.put("pe32.dll", "deps/PE32.DLL");
+  dir.put("not_pe.dll", "deps/dep_b.dll");
+  dir.put("truncated_header.dll", "deps/dep_a.dll");
+  dir.put("pe32.dll", "install/USER32.dll");
+  dir.put("pe32.dll", "install/KERNEL32.dll");
+
+  auto closure = computeDependencyClosure({kFixtures / "pe64.dll"},
+                                          {dir.path / "deps"},
+                                          {dir.path / "install"});
+  CHECK_EQ(join(fileNames(closure.files)), "PE32.DLL,dep_a.dll,dep_b.dll");
+  CHECK_EQ(join(sorted(closure.missing)), "dep_c.dll,legacy_delay.dll");
+  CHECK_EQ(closure.unreadable.size(), 2u);
+
+  // A dependency an earlier deploy put into the install dir is resolved from
+  // the dependency dirs again rather than counted as the program's.
+  dir.put("pe32.dll", "install/pe32.dll");
+  closure = computeDependencyClosure({kFixtures / "pe64.dll"},
+                                     {dir.path / "deps"},
+                                     {dir.path / "install"});
+  CHECK(closure.files.empty());
+  closure = computeDependencyClosure({kFixtures / "pe64.dll"},
+                                     {dir.path / "deps"},
+                                     {dir.path / "install"}, {"PE32.dll"});
+  CHECK_EQ(join(fileNames(closure.files)), "PE32.DLL,dep_a.dll,dep_b.dll");
+}
+
+} // namespace
+
+int main() {
+  testPe32();
+  testPe32Plus();
+  testMalformed();
+  testEveryTruncation();
+  testClosure();
+  return checkResult();
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <string>
+
+#include <fcntl.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// POSIX stand-ins for the Windows file mapping and auto-reset event the
+// framework and injector share the telemetry ring through, so the ring
+// protocol can run between two real processes on Linux.
+
+class SharedMemory {
+public:
+  static SharedMemory create(const std::string &name, std::size_t size) {
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      close(fd);
+      fd = -1;
+    }
+    return SharedMemory(name, fd, size, true);
+  }
+
+  static SharedMemory open(const std::string &name, std::size_t size) {
+    return SharedMemory(name, shm_open(name.c_str(), O_RDWR, 0), size, false);
+  }
+
+  SharedMemory(SharedMemory &&other) noexcept
+      : m_name(std::move(other.m_name)), m_memory(other.m_memory),
+        m_size(other.m_size), m_owner(other.m_owner) {
+    other.m_memory = nullptr;
+    other.m_owner = false;
+  }
+  SharedMemory(const SharedMemory &) = delete;
+  SharedMemory &operator=(const SharedMemory &) = delete;
+
+  ~SharedMemory() {
+    if (m_memory) munmap(m_memory, m_size);
+    if (m_owner) shm_unlink(m_name.c_str());
+  }
+
+  void *data() const { return m_memory; }
+
+private:
+  SharedMemory(std::string name, int fd, std::size_t size, bool owner)
+      : m_name(std::move(name)), m_size(size), m_owner(owner) {
+    if (fd < 0) return;
+    void *memory =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory != MAP_FAILED) m_memory = memory;
+  }
+
+  std::string m_name;
+  void *m_memory = nullptr;
+  std::size_t m_size;
+  bool m_owner;
+};
+
+// Like the Windows event: set() wakes one wait(), or the next one if nobody
+// is waiting yet.
+class WakeEvent {
+public:
+  static WakeEvent create(const std::string &name) {
+    sem_unlink(name.c_str());
+    return WakeEvent(name, sem_open(name.c_str(), O_CREAT | O_EXCL, 0600, 0),
+                     true);
+  }
+
+  static WakeEvent open(const std::string &name) {
+    return WakeEvent(name, sem_open(name.c_str(), 0), false);
+  }
+
+  WakeEvent(WakeEvent &&other) noexcept
+      : m_name(std::move(other.m_name)), m_semaphore(other.m_semaphore),
+        m_owner(other.m_owner) {
+    other.m_semaphore = SEM_FAILED;
+    other.m_owner = false;
+  }
+  WakeEvent(const WakeEvent &) = delete;
+  WakeEvent &operator=(const WakeEvent &) = delete;
+
+  ~WakeEvent() {
+    if (m_semaphore != SEM_FAILED) sem_close(m_semaphore);
+    if (m_owner) sem_unlink(m_name.c_str());
+  }
+
+  bool valid() const { return m_semaphore != SEM_FAILED; }
+
+  void set() {
+    // Auto-reset: at most one pending wake.
+    int value = 0;
+    if (sem_getvalue(m_semaphore, &value) == 0 && value > 0) return;
+    sem_post(m_semaphore);
+  }
+
+  // False on timeout.
+  bool wait(long timeoutMs) {
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+    while (sem_timedwait(m_semaphore, &deadline) != 0) {
+      if (errno != EINTR) return false;
+    }
+    return true;
+  }
+
+private:
+  WakeEvent(std::string name, sem_t *semaphore, bool owner)
+      : m_name(std::move(name)), m_semaphore(semaphore), m_owner(owner) {}
+
+  std::string m_name;
+  sem_t *m_semaphore;
+  bool m_owner;
+};
@@ -0,0 +1,181 @@
+#include "check.hpp"
+#include "remote_loader.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__unix__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define TB_TEST_RUN_STUB 1
+#endif
+
+using namespace remote_loader;
+
+namespace {
+
+uint32_t le32(const std::vector<uint8_t> &bytes, size_t offset) {
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; i--) value = (value << 8) | bytes[offset + i];
+  return value;
+}
+
+uint64_t le64(const std::vector<uint8_t> &bytes, size_t offset) {
+  return le32(bytes, offset) | (static_cast<uint64_t>(le32(bytes, offset + 4)) << 32);
+}
+
+// The path an entry points at, decoded back from UTF-16LE up to its NUL.
+std::u16string pathAt(const std::vector<uint8_t> &bytes, size_t header,
+                      size_t index) {
+  size_t at = header + le32(bytes, header + kHeaderSize + index * kEntrySize);
+  std::u16string path;
+  for (; at + 1 < bytes.size(); at += 2) {
+    auto c = static_cast<char16_t>(bytes[at] | (bytes[at + 1] << 8));
+    if (c == 0) break;
+    path.push_back(c);
+  }
+  return path;
+}
+
+void testLayout() {
+  const std::vector<std::u16string> paths = {u"C:\\a.dll", u"D:\\caf\u00e9\\b.dll",
+                                             u"\U0001F600.dll"};
+  auto payload = buildPayload(paths, 0x00007ffa11223344ULL, 0x00007ffa55667788ULL);
+  const size_t header = payload.dataOffset;
+  CHECK_EQ(header, kCodeSize);
+  // Data: header, three entries, then 9, 14 and 7 UTF-16 units with NULs.
+  CHECK_EQ(payload.bytes.size(), kCodeSize + 32 + 3 * 16 + (9 + 14 + 7) * 2);
+  CHECK_EQ(payload.bytes[0], 0x53); // push rbx
+  CHECK_EQ(payload.bytes[kCodeSize - 1], 0);
+
+  CHECK_EQ(le64(payload.bytes, header), 0x00007ffa11223344ULL);
+  CHECK_EQ(le64(payload.bytes, header + 8), 0x00007ffa55667788ULL);
+  CHECK_EQ(le32(payload.bytes, header + 16), 3u);
+  CHECK_EQ(le32(payload.bytes, header + 20), 0u);
+  CHECK_EQ(le64(payload.bytes, header + 24), 0u);
+
+  uint32_t expected = 32 + 3 * 16;
+  for (size_t i = 0; i < paths.size(); i++) {
+    const size_t entry = header + kHeaderSize + i * kEntrySize;
+    CHECK_EQ(le32(payload.bytes, entry), expected);
+    CHECK_EQ(le32(payload.bytes, entry + 4), 0u);
+    CHECK_EQ(le64(payload.bytes, entry + 8), 0u);
+    CHECK(pathAt(payload.bytes, header, i) == paths[i]);
+    const size_t terminator = header + expected + paths[i].size() * 2;
+    CHECK_EQ(payload.bytes[terminator], 0);
+    CHECK_EQ(payload.bytes[terminator + 1], 0);
+    expected += static_cast<uint32_t>((paths[i].size() + 1) * 2);
+  }
+  CHECK_EQ(header + expected, payload.bytes.size());
+
+  // Little-endian units, and a non-BMP character as its surrogate pair.
+  const size_t cafe = header + le32(payload.bytes, header + kHeaderSize + kEntrySize);
+  CHECK_EQ(payload.bytes[cafe + 6 * 2], 0xe9);
+  CHECK_EQ(payload.bytes[cafe + 6 * 2 + 1], 0x00);
+  const size_t emoji =
+      header + le32(payload.bytes, header + kHeaderSize + 2 * kEntrySize);
+  CHECK_EQ(le32(payload.bytes, emoji), 0xde00d83du);
+
+  auto empty = buildPayload({}, 1, 2);
+  CHECK_EQ(empty.bytes.size(), kCodeSize + kHeaderSize);
+  CHECK_EQ(le32(empty.bytes, kCodeSize + 16), 0u);
+}
+
+void testReadResults() {
+  std::vector<uint8_t> data(kHeaderSize + 2 * kEntrySize, 0);
+  auto put = [&](size_t offset, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) data[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+  };
+  put(kHeaderSize + 4, 0, 4);
+  put(kHeaderSize + 8, 0x00007ffa12345678ULL, 8);
+  put(kHeaderSize + kEntrySize + 4, 126, 4);
+  put(kHeaderSize + kEntrySize + 8, 0, 8);
+
+  auto results = readResults(data.data(), data.size(), 2);
+  CHECK_EQ(results.size(), size_t{2});
+  if (results.size() == 2) {
+    CHECK_EQ(results[0].module, 0x00007ffa12345678ULL);
+    CHECK_EQ(results[0].error, 0u);
+    CHECK_EQ(results[1].module, 0u);
+    CHECK_EQ(results[1].error, 126u);
+  }
+
+  // Too short for the header, or for the entries asked for.
+  CHECK(readResults(data.data(), kHeaderSize - 1, 0).empty());
+  CHECK(readResults(data.data(), data.size() - 1, 2).empty());
+  CHECK(readResults(data.data(), data.size(), 3).empty());
+  CHECK_EQ(readResults(data.data(), kHeaderSize + kEntrySize, 1).size(), size_t{1});
+}
+
+#ifdef TB_TEST_RUN_STUB
+
+// Stand-ins for kernel32 with the calling convention the stub uses.
+std::vector<std::u16string> g_loaded;
+uint32_t g_lastError = 0;
+
+__attribute__((ms_abi)) uint64_t fakeLoadLibraryW(const char16_t *path) {
+  std::u16string name(path);
+  g_loaded.push_back(name);
+  if (name.find(u"missing") != std::u16string::npos) {
+    g_lastError = 126; // ERROR_MOD_NOT_FOUND
+    return 0;
+  }
+  g_lastError = 0;
+  return 0x00007ffa00000000ULL + g_loaded.size() * 0x10000;
+}
+
+__attribute__((ms_abi)) uint32_t fakeGetLastError() { return g_lastError; }
+
+using Stub = __attribute__((ms_abi)) uint32_t (*)(void *);
+
+// Runs the stub from an executable mapping laid out as in the target: the
+// code page execute-read, the data after it read-write.
+void testStub() {
+  if (sysconf(_SC_PAGESIZE) > static_cast<long>(kCodeSize)) return;
+  const std::vector<std::u16string> paths = {u"C:\\one.dll", u"C:\\missing.dll",
+                                             u"C:\\t\u00e9o.dll"};
+  auto payload = buildPayload(paths, reinterpret_cast<uint64_t>(&fakeLoadLibraryW),
+                              reinterpret_cast<uint64_t>(&fakeGetLastError));
+  void *base = mmap(nullptr, payload.bytes.size(), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  CHECK(base != MAP_FAILED);
+  if (base == MAP_FAILED) return;
+  auto *bytes = static_cast<uint8_t *>(base);
+  std::memcpy(bytes, payload.bytes.data(), payload.bytes.size());
+  CHECK_EQ(mprotect(base, kCodeSize, PROT_READ | PROT_EXEC), 0);
+
+  auto stub = reinterpret_cast<Stub>(base);
+  const uint32_t loaded = stub(bytes + payload.dataOffset);
+  CHECK_EQ(loaded, 2u);
+  CHECK(g_loaded == paths);
+
+  const uint8_t *data = bytes + payload.dataOffset;
+  const size_t dataSize = payload.bytes.size() - payload.dataOffset;
+  CHECK_EQ(data[20] | (data[21] << 8) | (data[22] << 16) | (data[23] << 24), 2);
+  auto results = readResults(data, dataSize, paths.size());
+  CHECK_EQ(results.size(), paths.size());
+  if (results.size() == paths.size()) {
+    CHECK_EQ(results[0].module, 0x00007ffa00010000ULL);
+    CHECK_EQ(results[0].error, 0u);
+    CHECK_EQ(results[1].module, 0u);
+    CHECK_EQ(results[1].error, 126u);
+    CHECK_EQ(results[2].module, 0x00007ffa00030000ULL);
+    CHECK_EQ(results[2].error, 0u);
+  }
+  munmap(base, payload.bytes.size());
+}
+
+#endif
+
+} // namespace
+
+int main() {
+  testLayout();
+  testReadResults();
+#ifdef TB_TEST_RUN_STUB
+  testStub();
+#endif
+  return checkResult();
+}
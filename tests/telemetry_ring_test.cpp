@@ -0,0 +1,253 @@
+#include "check.hpp"
+#include "posix_shm.hpp"
+
+#include <toon_boom/ext/telemetry_ring.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+
+using namespace util::telemetry;
+
+namespace {
+
+constexpr std::uint32_t kSmallCapacity = 256;
+
+std::string shmName(const char *what) {
+  return "/tb-telemetry-test-" + std::to_string(getpid()) + "-" + what;
+}
+
+RecordHeader logHeader(std::uint32_t threadId = 1) {
+  RecordHeader header{};
+  header.kind = RecordKind::Log;
+  header.threadId = threadId;
+  std::memcpy(header.source, "test", 4);
+  return header;
+}
+
+std::string payloadOf(std::size_t size, char fill) {
+  return std::string(size, fill);
+}
+
+// Reads and consumes everything currently in the ring.
+std::vector<std::string> drain(RingReader &reader) {
+  std::vector<std::string> payloads;
+  while (auto record = reader.peek()) {
+    payloads.emplace_back(record->payload);
+    reader.consume();
+  }
+  return payloads;
+}
+
+struct LocalRing {
+  std::vector<std::uint64_t> storage;
+  RingHeader *header;
+
+  explicit LocalRing(std::uint32_t capacity)
+      : storage(mappingSize(capacity) / 8 + 1),
+        header(RingWriter::create(storage.data(), capacity)) {}
+  void *memory() { return storage.data(); }
+  char *data() { return reinterpret_cast<char *>(memory()) + kDataOffset; }
+};
+
+void testRoundTrip() {
+  LocalRing ring(kSmallCapacity);
+  RingWriter writer(ring.memory());
+  RingReader reader(ring.memory());
+  CHECK(reader.valid());
+  CHECK(!reader.peek());
+  CHECK(writer.write(logHeader(42), "hello"));
+  auto record = reader.peek();
+  CHECK(record);
+  if (!record) return;
+  CHECK_EQ(record->payload, "hello");
+  CHECK_EQ(record->source(), "test");
+  CHECK_EQ(record->header->threadId, 42u);
+  CHECK(record->header->kind == RecordKind::Log);
+  reader.consume();
+  CHECK(!reader.peek());
+}
+
+void testWrapWithPadding() {
+  LocalRing ring(kSmallCapacity);
+  RingWriter writer(ring.memory());
+  RingReader reader(ring.memory());
+  // Two 96-byte spans leave 64 bytes at the end: room for a padding header
+  // but not for the next 96-byte record.
+  const auto first = payloadOf(64, 'a');
+  const auto second = payloadOf(64, 'b');
+  const auto third = payloadOf(64, 'c');
+  CHECK_EQ(recordSpan(first.size()), 96u);
+  CHECK(writer.write(logHeader(), first));
+  CHECK(writer.write(logHeader(), second));
+  CHECK_EQ(drain(reader).size(), 2u);
+
+  CHECK(writer.write(logHeader(), third));
+  const auto *padding = reinterpret_cast<const RecordHeader *>(ring.data() + 192);
+  CHECK(padding->kind == RecordKind::Padding);
+  CHECK_EQ(padding->size, 64u - sizeof(RecordHeader));
+  // The record itself starts again at offset 0.
+  CHECK_EQ(std::string(ring.data() + sizeof(RecordHeader), 64), third);
+
+  auto records = drain(reader);
+  CHECK_EQ(records.size(), 1u);
+  if (!records.empty()) CHECK_EQ(records[0], third);
+  CHECK_EQ(ring.header->head.load(), 256u + 96u);
+  CHECK_EQ(ring.header->tail.load(), ring.header->head.load());
+}
+
+void testWrapWithoutRoomForPadding() {
+  LocalRing ring(kSmallCapacity);
+  RingWriter writer(ring.memory());
+  RingReader reader(ring.memory());
+  // 232 bytes used leaves 24 at the end, less than a record header, so the
+  // writer skips them without writing anything.
+  CHECK(writer.write(logHeader(), payloadOf(200, 'x')));
+  CHECK_EQ(drain(reader).size(), 1u);
+  std::memset(ring.data() + 232, 0x7f, 24);
+  CHECK(writer.write(logHeader(), "after"));
+  auto records = drain(reader);
+  CHECK_EQ(records.size(), 1u);
+  if (!records.empty()) CHECK_EQ(records[0], "after");
+  CHECK(reader.valid());
+}
+
+void testDrops() {
+  LocalRing ring(kSmallCapacity);
+  RingWriter writer(ring.memory());
+  RingReader reader(ring.memory());
+  // Larger than the whole ring.
+  CHECK(!writer.write(logHeader(), payloadOf(kSmallCapacity, 'z')));
+  CHECK_EQ(reader.dropped(), 1u);
+
+  std::size_t written = 0;
+  while (writer.write(logHeader(), payloadOf(24, 'f'))) written++;
+  CHECK_EQ(written, kSmallCapacity / 56);
+  CHECK_EQ(reader.dropped(), 2u);
+  CHECK(!writer.write(logHeader(), "still full"));
+  CHECK_EQ(reader.dropped(), 3u);
+
+  // Freeing one slot lets exactly one more record in.
+  CHECK(reader.peek());
+  reader.consume();
+  CHECK(writer.write(logHeader(), payloadOf(24, 'g')));
+  CHECK_EQ(drain(reader).size(), written);
+  CHECK_EQ(reader.dropped(), 3u);
+}
+
+void testCorruptRecord() {
+  LocalRing ring(kSmallCapacity);
+  RingWriter writer(ring.memory());
+  RingReader reader(ring.memory());
+  CHECK(writer.write(logHeader(), "fine"));
+  // A size that runs past what the writer published.
+  reinterpret_cast<RecordHeader *>(ring.data())->size = 1000;
+  CHECK(!reader.peek());
+  CHECK(!reader.valid());
+  // Stays failed even if the record is repaired.
+  reinterpret_cast<RecordHeader *>(ring.data())->size = 4;
+  CHECK(!reader.peek());
+}
+
+void testForeignMemory() {
+  LocalRing ring(kSmallCapacity);
+  {
+    ring.header->version = kVersion + 1;
+    RingReader reader(ring.memory());
+    CHECK(!reader.valid());
+    CHECK(!reader.peek());
+    ring.header->version = kVersion;
+  }
+  {
+    ring.header->capacity = 100; // not a power of two
+    RingReader reader(ring.memory());
+    CHECK(!reader.valid());
+    ring.header->capacity = kSmallCapacity;
+  }
+  std::vector<std::uint64_t> zeroes(mappingSize(kSmallCapacity) / 8);
+  RingReader reader(zeroes.data());
+  CHECK(!reader.valid());
+  CHECK(RingReader(ring.memory()).valid());
+}
+
+// The framework and injector as two processes: a child writes through
+// POSIX shared memory and signals the wake event only when the reader says
+// it is waiting; the parent sleeps on the event between bursts. A lost
+// wake-up shows up as a timeout.
+void testAcrossProcesses() {
+  constexpr std::uint32_t kCapacity = 4096;
+  constexpr int kRecords = 20000;
+  const auto memoryName = shmName("ring");
+  const auto eventName = shmName("event");
+  auto memory = SharedMemory::create(memoryName, mappingSize(kCapacity));
+  auto event = WakeEvent::create(eventName);
+  CHECK(memory.data());
+  CHECK(event.valid());
+  if (!memory.data() || !event.valid()) return;
+  RingWriter::create(memory.data(), kCapacity);
+
+  const pid_t child = fork();
+  if (child == 0) {
+    auto childMemory = SharedMemory::open(memoryName, mappingSize(kCapacity));
+    auto childEvent = WakeEvent::open(eventName);
+    if (!childMemory.data() || !childEvent.valid()) _exit(2);
+    RingWriter writer(childMemory.data());
+    for (int i = 0; i < kRecords; i++) {
+      const auto payload = std::to_string(i) + payloadOf(i % 97, '.');
+      // Wait out a full ring instead of dropping, so every record arrives.
+      while (!writer.write(logHeader(), payload)) {
+        if (writer.readerWaiting()) childEvent.set();
+        usleep(50);
+      }
+      if (writer.readerWaiting()) childEvent.set();
+      if (i % 1000 == 0) usleep(2000); // let the reader fall asleep
+    }
+    _exit(0);
+  }
+
+  RingReader reader(memory.data());
+  int expected = 0;
+  bool timedOut = false;
+  while (expected < kRecords && !timedOut) {
+    if (auto record = reader.peek()) {
+      const auto payload = std::string(record->payload);
+      const auto wanted = std::to_string(expected) + payloadOf(expected % 97, '.');
+      if (payload != wanted) {
+        CHECK_EQ(payload, wanted);
+        break;
+      }
+      reader.consume();
+      expected++;
+      continue;
+    }
+    reader.prepareWait();
+    if (!reader.peek()) timedOut = !event.wait(5000);
+    reader.finishWait();
+  }
+  CHECK(!timedOut);
+  CHECK_EQ(expected, kRecords);
+  CHECK(reader.valid());
+
+  // A writer stuck on a full ring would otherwise never exit.
+  if (expected != kRecords) kill(child, SIGKILL);
+  int status = 0;
+  waitpid(child, &status, 0);
+  CHECK(WIFEXITED(status));
+  CHECK_EQ(WEXITSTATUS(status), 0);
+}
+
+} // namespace
+
+int main() {
+  testRoundTrip();
+  testWrapWithPadding();
+  testWrapWithoutRoomForPadding();
+  testDrops();
+  testCorruptRecord();
+  testForeignMemory();
+  testAcrossProcesses();
+  return checkResult();
+}